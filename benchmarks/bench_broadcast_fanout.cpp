@@ -0,0 +1,205 @@
+#include "custom_net_lib.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+
+/*
+ * Benchmark: Fan-out latency of a broadcast to many clients on loopback.
+ *
+ * NUM_CLIENTS simulated clients (ConnectionInterface objects that share one
+ * I/O thread) connect to a server with 1, 2 and 4 I/O threads. For every
+ * broadcast the benchmark measures how long the call itself blocks the caller
+ * and how long it takes until the last client has received the message. Two
+ * strategies are compared:
+ *  - per connection: the caller posts one task per connection (the former
+ *    implementation of sendMessageToAllClients)
+ *  - per shard: the caller posts one task per I/O thread, which queues the
+ *    shared message at all connections of its shard
+ *
+ * Every client needs two file descriptors (client and server side of the
+ * connection), the benchmark raises its limit as far as allowed and reduces
+ * the number of clients if that is not enough.
+ *
+ * Usage: bench_broadcast_fanout [NUM_CLIENTS] [NUM_BROADCASTS]
+ */
+
+enum class BenchMsgTypes : uint32_t { Data };
+
+using Connection = custom_netlib::ConnectionInterface<BenchMsgTypes>;
+
+class BenchServer : public custom_netlib::ServerInterfaceClass<BenchMsgTypes> {
+public:
+  BenchServer(uint16_t port, const custom_netlib::ServerConfig &config)
+      : custom_netlib::ServerInterfaceClass<BenchMsgTypes>(port, config) {}
+
+  void onClientValidated(std::shared_ptr<Connection>) override {
+    num_validated++;
+  }
+
+  void broadcastPerConnection(
+      custom_netlib::SharedMessage<BenchMsgTypes> msg_to_send) {
+    // one task per connection, posted by the caller
+    for (auto &shard : shards_) {
+      std::unique_lock<std::mutex> lck(shard->connections_mtx);
+      for (const auto &connection : shard->connections) {
+        connection->SendData(msg_to_send);
+      }
+    }
+  }
+
+  std::atomic<size_t> num_validated{0};
+
+protected:
+  bool onClientConnect(std::shared_ptr<Connection>) override {
+    return true;
+  }
+};
+
+size_t raiseDescriptorLimit(size_t num_clients) {
+  // returns the number of clients that fit into the descriptor limit
+  const size_t reserved_descriptors = 64;
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+    size_t max_clients =
+        limit.rlim_cur > 2 * reserved_descriptors
+            ? (size_t(limit.rlim_cur) - reserved_descriptors) / 2
+            : 1;
+    return std::min(num_clients, max_clients);
+  }
+  return num_clients;
+}
+
+double percentile(std::vector<double> values, double p) {
+  std::sort(values.begin(), values.end());
+  return values[size_t(p * double(values.size() - 1))];
+}
+
+bool waitUntil(const std::atomic<size_t> &counter, size_t target,
+               std::chrono::seconds timeout) {
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (counter.load() < target) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::yield();
+  }
+  return true;
+}
+
+void runFanout(std::ostream &report, size_t num_io_threads,
+               size_t num_clients, size_t num_broadcasts, uint16_t port) {
+  // small receive buffers, since there are many connections on both sides
+  custom_netlib::ConnectionConfig connection_config;
+  connection_config.receive_buffer_bytes = 1024;
+
+  custom_netlib::ServerConfig server_config;
+  server_config.num_io_threads = num_io_threads;
+  server_config.connection = connection_config;
+  BenchServer server(port, server_config);
+  server.Start();
+
+  std::atomic<size_t> num_received{0};
+  custom_netlib::IoContextPool client_pool(1);
+  client_pool.run();
+  boost::asio::ip::tcp::resolver resolver(client_pool.at(0));
+  auto endpts = resolver.resolve("127.0.0.1", std::to_string(port));
+
+  std::vector<std::unique_ptr<Connection>> clients;
+  const size_t connect_chunk = 500; // stay below the listen backlog
+  for (size_t n = 0; n < num_clients; n++) {
+    clients.emplace_back(std::make_unique<Connection>(
+        Connection::Owner::client, client_pool.at(0),
+        boost::asio::ip::tcp::socket(client_pool.at(0)),
+        Connection::IncomingSink(
+            [&num_received](custom_netlib::OwnedMessage<BenchMsgTypes> &&) {
+              num_received++;
+            }),
+        connection_config));
+    Connection *client = clients.back().get();
+    boost::asio::post(client_pool.at(0),
+                      [client, &endpts]() { client->ConnectToServer(endpts); });
+    if ((n + 1) % connect_chunk == 0) {
+      waitUntil(server.num_validated, n + 1, std::chrono::seconds(30));
+    }
+  }
+  if (!waitUntil(server.num_validated, num_clients, std::chrono::seconds(30))) {
+    report << "only " << server.num_validated << " of " << num_clients
+           << " clients connected\n";
+  }
+
+  custom_netlib::message<BenchMsgTypes> msg;
+  msg.header.id = BenchMsgTypes::Data;
+  msg << uint64_t(0) << uint64_t(0);
+
+  for (bool per_shard : {false, true}) {
+    std::vector<double> call_us;
+    std::vector<double> fanout_us;
+    for (size_t b = 0; b < num_broadcasts; b++) {
+      num_received = 0;
+      auto shared_msg = custom_netlib::makeSharedMessage(msg);
+
+      auto t_start = std::chrono::steady_clock::now();
+      if (per_shard) {
+        server.sendMessageToAllClients(shared_msg, nullptr);
+      } else {
+        server.broadcastPerConnection(shared_msg);
+      }
+      auto t_call = std::chrono::steady_clock::now();
+      waitUntil(num_received, num_clients, std::chrono::seconds(30));
+      auto t_done = std::chrono::steady_clock::now();
+
+      call_us.push_back(
+          std::chrono::duration<double, std::micro>(t_call - t_start).count());
+      fanout_us.push_back(
+          std::chrono::duration<double, std::micro>(t_done - t_start).count());
+    }
+
+    report << std::left << std::setw(16)
+           << (per_shard ? "per shard" : "per connection") << std::right
+           << std::setw(10) << num_io_threads << std::setw(10) << num_clients
+           << std::fixed << std::setprecision(1) << std::setw(14)
+           << percentile(call_us, 0.5) << std::setw(14)
+           << percentile(fanout_us, 0.5) << std::setw(14)
+           << percentile(fanout_us, 0.99) << "\n";
+  }
+
+  client_pool.stop();
+  clients.clear();
+  server.Stop();
+}
+
+int main(int argc, char *argv[]) {
+  size_t num_clients = argc > 1 ? std::stoul(argv[1]) : 10000;
+  size_t num_broadcasts = argc > 2 ? std::stoul(argv[2]) : 50;
+
+  // the report goes to the real stdout, the log output of the library that
+  // is written for every connection is discarded
+  std::ostream report(std::cout.rdbuf());
+  std::cout.rdbuf(nullptr);
+
+  size_t usable_clients = raiseDescriptorLimit(num_clients);
+  if (usable_clients < num_clients) {
+    report << "descriptor limit allows only " << usable_clients
+           << " clients\n";
+    num_clients = usable_clients;
+  }
+
+  report << std::left << std::setw(16) << "strategy" << std::right
+         << std::setw(10) << "threads" << std::setw(10) << "clients"
+         << std::setw(14) << "call [us]" << std::setw(14) << "p50 [us]"
+         << std::setw(14) << "p99 [us]"
+         << "\n";
+
+  uint16_t port = 20200; // below the ephemeral ports of the clients
+  for (size_t num_io_threads : {1, 2, 4}) {
+    runFanout(report, num_io_threads, num_clients, num_broadcasts, port++);
+  }
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include "custom_net_lib.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/*
+ * Benchmark: Round trip time of a ping on loopback, like the ping of
+ * custom_client against custom_server. The client sends a ping, waits within
+ * Incoming().wait() for the answer and sends the next one. The server answers
+ * the ping in two modes:
+ *  - queued: the ping goes through the incoming queue of the server and is
+ *    answered by the thread that calls update()
+ *  - inline: the ping is registered with setInlineDispatch() and answered
+ *    directly within the I/O thread of the connection
+ *
+ * Usage: bench_ping_rtt [NUM_PINGS]
+ */
+
+enum class BenchMsgTypes : uint32_t { ServerPing };
+
+class BenchServer : public custom_netlib::ServerInterfaceClass<BenchMsgTypes> {
+public:
+  BenchServer(uint16_t port)
+      : custom_netlib::ServerInterfaceClass<BenchMsgTypes>(port) {}
+
+protected:
+  bool onClientConnect(
+      std::shared_ptr<custom_netlib::ConnectionInterface<BenchMsgTypes>>)
+      override {
+    return true;
+  }
+
+  void onMessage(
+      std::shared_ptr<custom_netlib::ConnectionInterface<BenchMsgTypes>> client,
+      custom_netlib::message<BenchMsgTypes> &msg_input) override {
+    client->SendData(std::move(msg_input),
+                     custom_netlib::MessagePriority::High);
+  }
+};
+
+double percentile(std::vector<double> values, double p) {
+  std::sort(values.begin(), values.end());
+  return values[size_t(p * double(values.size() - 1))];
+}
+
+void runPings(std::ostream &report, bool inline_dispatch, size_t num_pings,
+              uint16_t port) {
+  BenchServer server(port);
+  if (inline_dispatch) {
+    server.setInlineDispatch(BenchMsgTypes::ServerPing);
+  }
+  server.Start();
+
+  std::atomic<bool> running{true};
+  std::thread thr_update;
+  if (!inline_dispatch) {
+    thr_update = std::thread([&server, &running]() {
+      while (running) {
+        server.update(-1, true);
+      }
+    });
+  }
+
+  custom_netlib::ClientBaseInterface<BenchMsgTypes> client;
+  client.Connect("127.0.0.1", port);
+  while (!client.isConnected()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  custom_netlib::message<BenchMsgTypes> ping;
+  ping.header.id = BenchMsgTypes::ServerPing;
+  ping << uint64_t(0);
+  auto ping_once = [&client, &ping]() {
+    auto t_start = std::chrono::steady_clock::now();
+    client.Send(ping, custom_netlib::MessagePriority::High);
+    client.Incoming().wait();
+    client.Incoming().popFront();
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - t_start)
+        .count();
+  };
+
+  const size_t num_warmup_pings = 100; // includes the handshake
+  for (size_t i = 0; i < num_warmup_pings; i++) {
+    ping_once();
+  }
+  std::vector<double> rtt_us;
+  rtt_us.reserve(num_pings);
+  for (size_t i = 0; i < num_pings; i++) {
+    rtt_us.push_back(ping_once());
+  }
+
+  // the last ping wakes up the update thread, so it sees the stop flag
+  running = false;
+  ping_once();
+  if (thr_update.joinable()) {
+    thr_update.join();
+  }
+
+  report << std::left << std::setw(10) << (inline_dispatch ? "inline" : "queued")
+         << std::right << std::fixed << std::setprecision(1) << std::setw(14)
+         << percentile(rtt_us, 0.5) << std::setw(14) << percentile(rtt_us, 0.99)
+         << "\n";
+
+  client.Disconnect();
+  server.Stop();
+}
+
+int main(int argc, char *argv[]) {
+  size_t num_pings = argc > 1 ? std::stoul(argv[1]) : 10000;
+
+  // the report goes to the real stdout, the log output of the library is
+  // discarded
+  std::ostream report(std::cout.rdbuf());
+  std::cout.rdbuf(nullptr);
+
+  report << std::left << std::setw(10) << "mode" << std::right << std::setw(14)
+         << "p50 [us]" << std::setw(14) << "p99 [us]"
+         << "\n";
+
+  uint16_t port = 20300; // below the ephemeral ports of the client
+  for (bool inline_dispatch : {false, true}) {
+    runPings(report, inline_dispatch, num_pings, port++);
+  }
+
+  return 0;
+}
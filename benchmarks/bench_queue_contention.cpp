@@ -0,0 +1,117 @@
+#include "custom_net_lib.hpp"
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/*
+ * Benchmark: Throughput of the incoming message queue of the server under
+ * contention. NUM_PRODUCERS threads (the I/O threads of the connections) push
+ * owned messages concurrently while ONE consumer thread (the thread that calls
+ * update() on the server) takes them out again.
+ *
+ * - TsNetQueue: the consumer checks isEmpty() and calls popFront() per message
+ *   (two lock acquisitions per message)
+ * - TsNetQueue popAll: the consumer swaps out the whole deque under one lock
+ *   (what update() does)
+ * - LockFreeMpscQueue: the consumer takes everything at once with drain()
+ *
+ * Usage: bench_queue_contention [NUM_MESSAGES]
+ */
+
+enum class BenchMsgTypes : uint32_t { Data };
+
+using OwnedBenchMessage = custom_netlib::OwnedMessage<BenchMsgTypes>;
+
+OwnedBenchMessage makeMessage(uint32_t value) {
+  OwnedBenchMessage owned_msg;
+  owned_msg.msg.header.id = BenchMsgTypes::Data;
+  owned_msg.msg << value;
+  return owned_msg;
+}
+
+template <typename Queue, typename ConsumeFunction>
+double runProducers(Queue &queue, size_t num_producers, size_t num_messages,
+                    ConsumeFunction consume) {
+  std::vector<std::thread> producers;
+  size_t messages_per_producer = num_messages / num_producers;
+
+  auto t_start = std::chrono::steady_clock::now();
+  for (size_t p = 0; p < num_producers; p++) {
+    producers.emplace_back([&queue, messages_per_producer]() {
+      for (size_t i = 0; i < messages_per_producer; i++) {
+        queue.pushBack(makeMessage(uint32_t(i)));
+      }
+    });
+  }
+
+  size_t consumed = 0;
+  while (consumed < messages_per_producer * num_producers) {
+    consumed += consume(queue);
+  }
+  auto t_end = std::chrono::steady_clock::now();
+
+  for (auto &producer : producers) {
+    producer.join();
+  }
+  return std::chrono::duration<double, std::milli>(t_end - t_start).count();
+}
+
+void printResult(const std::string &name, size_t num_producers,
+                 size_t num_messages, double elapsed_ms) {
+  std::cout << std::left << std::setw(20) << name << std::right
+            << std::setw(12) << num_producers << std::setw(14) << std::fixed
+            << std::setprecision(2) << elapsed_ms << std::setw(16)
+            << double(num_messages) / elapsed_ms / 1000.0 << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  size_t num_messages = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+  std::cout << std::left << std::setw(20) << "queue" << std::right
+            << std::setw(12) << "producers" << std::setw(14) << "time [ms]"
+            << std::setw(16) << "Mmsgs/s" << "\n";
+
+  for (size_t num_producers : {1, 2, 4, 8}) {
+    {
+      custom_netlib::TsNetQueue<OwnedBenchMessage> queue;
+      double elapsed_ms = runProducers(
+          queue, num_producers, num_messages,
+          [](custom_netlib::TsNetQueue<OwnedBenchMessage> &q) {
+            size_t consumed = 0;
+            while (!q.isEmpty()) {
+              OwnedBenchMessage owned_msg = q.popFront();
+              consumed++;
+            }
+            return consumed;
+          });
+      printResult("TsNetQueue", num_producers, num_messages, elapsed_ms);
+    }
+    {
+      custom_netlib::TsNetQueue<OwnedBenchMessage> queue;
+      std::deque<OwnedBenchMessage> batch;
+      double elapsed_ms = runProducers(
+          queue, num_producers, num_messages,
+          [&batch](custom_netlib::TsNetQueue<OwnedBenchMessage> &q) {
+            batch.clear();
+            return q.popAll(batch);
+          });
+      printResult("TsNetQueue popAll", num_producers, num_messages,
+                  elapsed_ms);
+    }
+    {
+      custom_netlib::LockFreeMpscQueue<OwnedBenchMessage> queue;
+      std::vector<OwnedBenchMessage> batch;
+      double elapsed_ms = runProducers(
+          queue, num_producers, num_messages,
+          [&batch](custom_netlib::LockFreeMpscQueue<OwnedBenchMessage> &q) {
+            batch.clear();
+            return q.drain(batch);
+          });
+      printResult("LockFreeMpscQueue", num_producers, num_messages,
+                  elapsed_ms);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,79 @@
+#include "custom_net_lib.hpp"
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/*
+ * Benchmark: Wakeup latency of TsNetQueue::wait(). A producer pushes the time
+ * stamp of the push and the consumer, that is blocked within wait(), measures
+ * how long it took until it got the element.
+ *
+ * With a gap of 1ms between two pushes, the consumer has always given up
+ * spinning and is parked on the condition variable. With a short gap, the
+ * element arrives while the consumer still spins (on machines with more than
+ * one core).
+ *
+ * Usage: bench_queue_wakeup [NUM_WAKEUPS]
+ */
+
+using time_point = std::chrono::steady_clock::time_point;
+
+void runWakeups(const std::string &name, size_t num_wakeups,
+                std::chrono::microseconds gap,
+                std::chrono::nanoseconds spin_duration) {
+  custom_netlib::TsNetQueue<time_point> queue;
+  queue.setSpinDuration(spin_duration);
+
+  std::vector<double> latencies_us;
+  latencies_us.reserve(num_wakeups);
+
+  std::thread thr_consumer([&queue, &latencies_us, num_wakeups]() {
+    for (size_t i = 0; i < num_wakeups; i++) {
+      queue.wait();
+      time_point pushed = queue.popFront();
+      latencies_us.push_back(std::chrono::duration<double, std::micro>(
+                                 std::chrono::steady_clock::now() - pushed)
+                                 .count());
+    }
+  });
+
+  for (size_t i = 0; i < num_wakeups; i++) {
+    auto gap_end = std::chrono::steady_clock::now() + gap;
+    while (std::chrono::steady_clock::now() < gap_end) {
+      std::this_thread::yield(); // let the consumer spin or park
+    }
+    queue.pushBack(std::chrono::steady_clock::now());
+  }
+  thr_consumer.join();
+
+  std::sort(latencies_us.begin(), latencies_us.end());
+  auto percentile = [&latencies_us](double p) {
+    return latencies_us[size_t(p * (latencies_us.size() - 1))];
+  };
+  std::cout << std::left << std::setw(26) << name << std::right
+            << std::setw(10) << spin_duration.count() / 1000 << std::fixed
+            << std::setprecision(2) << std::setw(12) << percentile(0.5)
+            << std::setw(12) << percentile(0.99) << std::setw(12)
+            << latencies_us.back() << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  size_t num_wakeups = argc > 1 ? std::stoul(argv[1]) : 2000;
+
+  std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+            << "\n";
+  std::cout << std::left << std::setw(26) << "scenario" << std::right
+            << std::setw(10) << "spin [us]" << std::setw(12) << "p50 [us]"
+            << std::setw(12) << "p99 [us]" << std::setw(12) << "max [us]"
+            << "\n";
+
+  runWakeups("parked (gap 1ms)", num_wakeups, std::chrono::microseconds(1000),
+             std::chrono::microseconds(0));
+  runWakeups("parked (gap 1ms)", num_wakeups, std::chrono::microseconds(1000),
+             std::chrono::microseconds(50));
+  runWakeups("spinning (gap 10us)", num_wakeups,
+             std::chrono::microseconds(10), std::chrono::microseconds(50));
+
+  return 0;
+}
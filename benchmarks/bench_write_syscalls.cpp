@@ -0,0 +1,203 @@
+#include "custom_net_lib.hpp"
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+/*
+ * Benchmark: How many write system calls does it cost to send one message of
+ * the custom message protocol through a TCP socket?
+ *
+ * Every async_write_some() that boost::asio issues on a TCP socket ends up in
+ * (at least) one sendmsg() system call. The CountingSocket wrapper counts these
+ * calls, so the benchmark reports the number of write system calls per message
+ * for the different ways of writing the header and the payload of a message.
+ * The coalesced strategy simulates a full out queue (e.g. during a broadcast
+ * storm) that is written in batches limited by the default ConnectionConfig.
+ *
+ * Usage: bench_write_syscalls [NUM_MESSAGES] [PAYLOAD_BYTES]
+ */
+
+enum class BenchMsgTypes : uint32_t { Data };
+
+using tcp = boost::asio::ip::tcp;
+
+class CountingSocket {
+  // minimal AsyncWriteStream that forwards everything to a TCP socket and
+  // counts the issued write operations
+public:
+  using executor_type = tcp::socket::executor_type;
+
+  explicit CountingSocket(tcp::socket &sock) : sock_(sock) {}
+
+  executor_type get_executor() { return sock_.get_executor(); }
+
+  template <typename ConstBufferSequence, typename WriteHandler>
+  auto async_write_some(const ConstBufferSequence &buffers,
+                        WriteHandler &&handler) {
+    write_calls_++;
+    return sock_.async_write_some(buffers,
+                                  std::forward<WriteHandler>(handler));
+  }
+
+  size_t writeCalls() const { return write_calls_; }
+
+private:
+  tcp::socket &sock_;
+  size_t write_calls_ = 0;
+};
+
+enum class WriteMode { Separate, Gather, Coalesced };
+
+class WriteStrategy {
+  // sends NUM_MESSAGES copies of a message one after another (the next write
+  // is started from the completion handler of the previous one, exactly like
+  // the out queue of the ConnectionInterface does it)
+public:
+  WriteStrategy(CountingSocket &stream,
+                const custom_netlib::message<BenchMsgTypes> &msg,
+                size_t num_messages, WriteMode mode)
+      : stream_(stream), msg_(msg), remaining_(num_messages), mode_(mode) {}
+
+  void start() { writeNext(); }
+
+private:
+  void writeNext() {
+    if (remaining_ == 0) {
+      return;
+    }
+
+    if (mode_ == WriteMode::Coalesced) {
+      // as many queued messages as the limits of the connection config allow
+      custom_netlib::ConnectionConfig config;
+      size_t msg_bytes = sizeof(msg_.header) + msg_.payload.size();
+      batch_buffers_.clear();
+      size_t batch_bytes = 0;
+      while (remaining_ > 0 &&
+             (batch_buffers_.empty() ||
+              ((batch_bytes + msg_bytes <= config.max_write_batch_bytes) &&
+               (batch_buffers_.size() + 2 <=
+                config.max_write_batch_buffers)))) {
+        batch_buffers_.emplace_back(
+            boost::asio::buffer(&msg_.header, sizeof(msg_.header)));
+        batch_buffers_.emplace_back(
+            boost::asio::buffer(msg_.payload.data(), msg_.payload.size()));
+        batch_bytes += msg_bytes;
+        remaining_--;
+      }
+      boost::asio::async_write(
+          stream_, batch_buffers_,
+          [this](boost::system::error_code ec, std::size_t) {
+            if (!ec) {
+              writeNext();
+            }
+          });
+      return;
+    }
+    remaining_--;
+
+    if (mode_ == WriteMode::Gather) {
+      // header and payload within one buffer sequence
+      std::array<boost::asio::const_buffer, 2> frame_buffers{
+          boost::asio::buffer(&msg_.header, sizeof(msg_.header)),
+          boost::asio::buffer(msg_.payload.data(), msg_.payload.size())};
+      boost::asio::async_write(
+          stream_, frame_buffers,
+          [this](boost::system::error_code ec, std::size_t) {
+            if (!ec) {
+              writeNext();
+            }
+          });
+    } else {
+      // first the header, then the payload from the completion handler
+      boost::asio::async_write(
+          stream_, boost::asio::buffer(&msg_.header, sizeof(msg_.header)),
+          [this](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+              return;
+            }
+            boost::asio::async_write(
+                stream_,
+                boost::asio::buffer(msg_.payload.data(), msg_.payload.size()),
+                [this](boost::system::error_code ec, std::size_t) {
+                  if (!ec) {
+                    writeNext();
+                  }
+                });
+          });
+    }
+  }
+
+  CountingSocket &stream_;
+  const custom_netlib::message<BenchMsgTypes> &msg_;
+  size_t remaining_;
+  WriteMode mode_;
+  std::vector<boost::asio::const_buffer> batch_buffers_;
+};
+
+void runStrategy(const std::string &name, WriteMode mode, size_t num_messages,
+                 const custom_netlib::message<BenchMsgTypes> &msg) {
+  boost::asio::io_context ioserv;
+  tcp::acceptor acceptor(ioserv,
+                         tcp::endpoint(boost::asio::ip::make_address(
+                                           "127.0.0.1"),
+                                       0));
+  tcp::socket sender(ioserv);
+  sender.connect(acceptor.local_endpoint());
+  tcp::socket receiver = acceptor.accept();
+
+  // drain the receiving side in its own thread, so the sender never blocks on
+  // a full socket buffer for longer than necessary
+  const size_t bytes_expected =
+      num_messages * (sizeof(msg.header) + msg.payload.size());
+  std::thread thr_receiver([&receiver, bytes_expected]() {
+    std::vector<char> sink(64 * 1024);
+    size_t bytes_received = 0;
+    boost::system::error_code ec;
+    while (bytes_received < bytes_expected && !ec) {
+      bytes_received +=
+          receiver.read_some(boost::asio::buffer(sink.data(), sink.size()), ec);
+    }
+  });
+
+  CountingSocket stream(sender);
+  WriteStrategy strategy(stream, msg, num_messages, mode);
+
+  auto t_start = std::chrono::steady_clock::now();
+  strategy.start();
+  ioserv.run();
+  thr_receiver.join();
+  auto t_end = std::chrono::steady_clock::now();
+
+  double elapsed_ms =
+      std::chrono::duration<double, std::milli>(t_end - t_start).count();
+  std::cout << std::left << std::setw(28) << name << std::right
+            << std::setw(12) << num_messages << std::setw(14)
+            << stream.writeCalls() << std::setw(14) << std::fixed
+            << std::setprecision(2)
+            << double(stream.writeCalls()) / double(num_messages)
+            << std::setw(14) << elapsed_ms << "\n";
+}
+
+int main(int argc, char *argv[]) {
+  size_t num_messages = argc > 1 ? std::stoul(argv[1]) : 100000;
+  size_t payload_bytes = argc > 2 ? std::stoul(argv[2]) : 32;
+
+  custom_netlib::message<BenchMsgTypes> msg;
+  msg.header.id = BenchMsgTypes::Data;
+  for (size_t i = 0; i < payload_bytes; i++) {
+    msg << uint8_t(i);
+  }
+
+  std::cout << "payload of " << msg.payload.size() << " bytes per message\n";
+  std::cout << std::left << std::setw(28) << "strategy" << std::right
+            << std::setw(12) << "messages" << std::setw(14) << "write calls"
+            << std::setw(14) << "calls/msg" << std::setw(14) << "time [ms]"
+            << "\n";
+
+  runStrategy("header + payload", WriteMode::Separate, num_messages, msg);
+  runStrategy("gather write", WriteMode::Gather, num_messages, msg);
+  runStrategy("coalesced queue", WriteMode::Coalesced, num_messages, msg);
+
+  return 0;
+}
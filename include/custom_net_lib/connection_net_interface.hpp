@@ -2,14 +2,15 @@
 #define CONNECTIONNET
 
 #include "common_net_includes.hpp"
+#include "net_backpressure_gate.hpp"
+#include "net_circular_buffer.hpp"
+#include "net_config.hpp"
 #include "net_message.hpp"
+#include "net_token_bucket.hpp"
 #include "net_ts_queue.hpp"
 
 namespace custom_netlib {
 
-// forward declaration
-template <typename T> class ServerInterfaceClass;
-
 template <typename T>
 class ConnectionInterface
     : public std::enable_shared_from_this<ConnectionInterface<T>>
@@ -24,12 +25,46 @@ public:
     client
   };
 
+  using IncomingSink = std::function<void(OwnedMessage<T> &&)>;
+
+  // the ring buffer holds at least the header and the message size of a first
+  // fragment, a frame holds at least the message size and some payload
+  static constexpr size_t kMinReceiveBufferBytes =
+      sizeof(message_header<T>) + sizeof(uint32_t);
+  static constexpr size_t kMinFramePayloadBytes = 64;
+
   // parts of the rule of five
+  template <typename InputQueue>
+  ConnectionInterface(Owner parent, boost::asio::io_context &ioservobj,
+                      boost::asio::ip::tcp::socket sock,
+                      InputQueue &input_queue,
+                      const ConnectionConfig &config = ConnectionConfig())
+      : ConnectionInterface(parent, ioservobj, std::move(sock),
+                            IncomingSink([&input_queue](
+                                             OwnedMessage<T> &&owned_msg) {
+                              input_queue.pushBack(std::move(owned_msg));
+                            }),
+                            config) {
+    // The input queue can be every queue type with a pushBack(T &&) method
+    // (e.g. TsNetQueue or LockFreeMpscQueue), so the owner of the connection
+    // decides at compile time which queue implementation it uses
+  }
+
   ConnectionInterface(Owner parent, boost::asio::io_context &ioservobj,
                       boost::asio::ip::tcp::socket sock,
-                      TsNetQueue<OwnedMessage<T>> &input_queue)
+                      IncomingSink incoming_sink,
+                      const ConnectionConfig &config = ConnectionConfig())
       : io_service_object_(ioservobj), socket_connection_(std::move(sock)),
-        in_msg_queue_(input_queue) {
+        in_msg_queue_push_(std::move(incoming_sink)), config_(config),
+        in_buffer_(std::max(config.receive_buffer_bytes,
+                            kMinReceiveBufferBytes)),
+        receive_msg_bucket_(makeBucket(config.max_receive_messages_per_second,
+                                       config.receive_burst_seconds)),
+        receive_byte_bucket_(makeBucket(config.max_receive_bytes_per_second,
+                                        config.receive_burst_seconds)) {
+    // Every received message is handed to the incoming sink (called from
+    // within the I/O service object), so the owner decides what happens with
+    // it (e.g. push it into a queue or hand it to a worker thread)
     std::cout << "Connection element created!\n";
     owner_ = parent;
 
@@ -65,14 +100,17 @@ public:
           [this](boost::system::error_code ec,
                  boost::asio::ip::tcp::endpoint endpt) {
             if (!ec) {
-              ReadServerValidationRequest(); // calls ReadHeader() recursion
+              ReadServerValidationRequest(); // calls ReadFrames() recursion
                                              // implicizly // ReadValidation
-              // ReadHeader(); // if the asynchronous task, that was registered
+            } else {
+              std::cout << "[CLIENT]: Connecting to the server failed.\n";
+              CloseAfterReadError();
+              // ReadFrames(); // if the asynchronous task, that was registered
               // by
               // the I/O context ioserv_, of connection to the
               // server is finished, the connection handler will
               // be executed within the thread where the ioserv_
-              // is running in. Therefore, the ReadHeader() method
+              // is running in. Therefore, the ReadFrames() method
               // is used to prime the I/O service object with
               // another asynchronous task that should listen for
               // and read out messages from the server
@@ -84,8 +122,8 @@ public:
     return true;
   }
 
-  bool ConnectToClient(custom_netlib::ServerInterfaceClass<T> *server,
-                       uint32_t u_id = 0) {
+  template <typename ServerType>
+  bool ConnectToClient(ServerType *server, uint32_t u_id = 0) {
     // Only necessary if the associated Owner is a server --> Only called by
     // servers => Here we can implement the handshake for the server side
     if (owner_ == Owner::server) {
@@ -99,10 +137,10 @@ public:
 
         // read the response from the client in order to check if the puzzle was
         // solved successfully
-        ReadAndCheckValidation(server); // calls ReadHeader() recursion
+        ReadAndCheckValidation(server); // calls ReadFrames() recursion
                                         // implicizly // ReadValidation
 
-        // ReadHeader(); // register the I/O object / I/O service within the I/O
+        // ReadFrames(); // register the I/O object / I/O service within the I/O
         // service object of boost::asio --> We want our server to
         // read messages as soon as they appear on the socket
       }
@@ -112,10 +150,25 @@ public:
 
   uint32_t getID() const { return id_; }
 
+  std::shared_ptr<ConnectionInterface<T>> keepAlive() {
+    // Every asynchronous handler of the connection holds this reference, so a
+    // connection that is owned by a shared_ptr (server side) lives until its
+    // last handler has run, even if the server dropped it in the meantime
+    // (e.g. after reaping an idle client). A client connection is not owned
+    // by a shared_ptr (nullptr), its client joins the I/O thread first
+    return this->weak_from_this().lock();
+  }
+
   bool Disconnect() {
     if (IsConnected()) {
+      // the task keeps a connection that is owned by a shared_ptr (server
+      // side) alive until the socket is closed, even if the owner drops it
+      // right after this call
       boost::asio::post(io_service_object_,
-                        [this]() { socket_connection_.close(); });
+                        [this, self = keepAlive()]() {
+                          boost::system::error_code ec;
+                          socket_connection_.close(ec);
+                        });
     }
     return true;
   }
@@ -125,163 +178,771 @@ public:
     return socket_connection_.is_open();
   }
 
-  bool SendData(const message<T> &msg_to_send) {
-    boost::asio::post(io_service_object_, [this, msg_to_send]() {
-      bool writingMsgFlag =
-          !out_msg_queue_.isEmpty(); // if the out queue is not empty, we
-                                     // assume, that boost::asio is currently
-                                     // sending them throu the socket.
-
-      out_msg_queue_.pushBack(msg_to_send);
-      if (!writingMsgFlag) { // we do not want to add another WriteHeader
-                             // workload to the boost::asio I/O service object,
-                             // since it is already within the scheduling. We
-                             // only want to prime the I/O service object with
-                             // new sending work, if there are currently no
-                             // messages to send and then the newly added
-                             // message will be sent
-        WriteHeader(); // WriteHeader has an intrinsic loop that writes messages
-                       // until the out_msg_queue_ is empty!
-      }
-    });
+  bool SendData(const message<T> &msg_to_send,
+                MessagePriority priority = MessagePriority::Normal) {
+    return SendData(makeSharedMessage(msg_to_send), priority);
+  }
+
+  bool SendData(message<T> &&msg_to_send,
+                MessagePriority priority = MessagePriority::Normal) {
+    // the payload is moved into the shared message, so a message that is
+    // handed over as rvalue travels to the socket without any copy
+    return SendData(makeSharedMessage(std::move(msg_to_send)), priority);
+  }
+
+  bool SendData(SharedMessage<T> msg_to_send,
+                MessagePriority priority = MessagePriority::Normal) {
+    // only the reference to the immutable message is handed over to the I/O
+    // service object and stored within the out queue, so sending the same
+    // shared message to many connections does not copy its bytes
+    boost::asio::post(io_service_object_,
+                      [this, self = keepAlive(),
+                       msg_to_send = std::move(msg_to_send),
+                       priority]() mutable {
+                        QueueMessage(std::move(msg_to_send), priority);
+                      });
     return true;
   }
 
+  void QueueMessage(SharedMessage<T> msg_to_send,
+                    MessagePriority priority = MessagePriority::Normal) {
+    // CAUTION: must only be called from within the I/O service object of the
+    // connection (SendData() does this for every other thread). This allows
+    // the owner to queue a message for many connections with one single task
+    // on their I/O service object
+    size_t msg_bytes = frameBytes(*msg_to_send);
+    // the priority lane only holds messages that fit into one frame (a
+    // fragmented message would block the lane), larger ones are queued as
+    // normal messages. Control frames always take the priority lane and are
+    // the only messages that are not limited by the out queue policy
+    bool control_frame = msg_to_send->header.flags & kControlFlags;
+    bool priority_lane =
+        control_frame || (priority == MessagePriority::High &&
+                          msg_to_send->payload.size() <= maxFramePayload());
+    if (!control_frame &&
+        !AdmitToOutQueue(msg_to_send, msg_bytes, priority_lane)) {
+      return;
+    }
+    (priority_lane ? out_priority_queue_ : out_msg_queue_)
+        .emplace_back(std::move(msg_to_send));
+    out_queue_bytes_ += msg_bytes;
+    if (validation_sent_ &&
+        out_frame_batch_.empty()) { // we do not want to add another
+                                  // WriteMessages workload to the boost::asio
+                                  // I/O service object if there is a batch
+                                  // of messages currently sent throu the
+                                  // socket. The completion handler of that
+                                  // write picks up the newly added message.
+                                  // Before the handshake data is sent, the
+                                  // messages just wait within the queue
+      WriteMessages(); // WriteMessages has an intrinsic loop that writes
+                       // messages until the out_msg_queue_ is empty!
+    }
+  }
+
+  void SendHeartbeat() {
+    // CAUTION: must only be called from within the I/O service object of the
+    // connection. The communication partner answers with a heartbeat reply,
+    // which refreshes the time of the last receive
+    QueueMessage(controlMessage(kFlagHeartbeatRequest), MessagePriority::High);
+  }
+
+  void SetOutQueueFullHandler(std::function<void()> handler) {
+    // The handler is posted to the I/O service object when the out queue
+    // reaches its high-water mark, so it runs after the message that hit the
+    // mark was handled. It is posted again after the queue has been written
+    // out completely and reaches the mark once more
+    out_queue_full_handler_ = std::move(handler);
+  }
+
+  void SetCloseHandler(std::function<void()> handler) {
+    // The handler is called (within the I/O service object) once the
+    // connection has noticed that it is closed, e.g. because the
+    // communication partner closed it. CAUTION: must be called before the
+    // connection reads. A read that is paused (rate limit, backpressure)
+    // notices the close when it continues
+    close_handler_ = std::move(handler);
+  }
+
+  struct OutQueueStats {
+    uint64_t num_dropped = 0;   // messages dropped by the out queue policy
+    uint64_t num_coalesced = 0; // messages replaced by a newer one
+  };
+
+  size_t OutQueueSize() const {
+    // CAUTION: must only be called from within the I/O service object of the
+    // connection
+    return out_msg_queue_.size() + out_priority_queue_.size();
+  }
+
+  OutQueueStats getOutQueueStats() const {
+    // can be called from every thread
+    OutQueueStats stats;
+    stats.num_dropped = num_out_dropped_.load();
+    stats.num_coalesced = num_out_coalesced_.load();
+    return stats;
+  }
+
+  std::chrono::steady_clock::time_point lastReceiveTime() const {
+    // CAUTION: must only be called from within the I/O service object of the
+    // connection. A connection that does not read because of its rate limit
+    // (or because its consumer is behind) counts as active
+    return read_paused_ ? std::chrono::steady_clock::now()
+                        : last_receive_time_;
+  }
+
+  struct WriteStats {
+    uint64_t num_writes = 0; // write operations of the socket
+    uint64_t num_frames = 0; // frames written by them
+  };
+
+  WriteStats getWriteStats() const {
+    // can be called from every thread
+    WriteStats stats;
+    stats.num_writes = num_writes_.load();
+    stats.num_frames = num_written_frames_.load();
+    return stats;
+  }
+
+  struct ThrottleStats {
+    uint64_t num_pauses = 0; // how often the reading was paused
+    std::chrono::nanoseconds throttled_time{0}; // sum of all pauses
+  };
+
+  ThrottleStats getThrottleStats() const {
+    // can be called from every thread (a running pause is not included)
+    ThrottleStats stats;
+    stats.num_pauses = num_throttle_pauses_.load();
+    stats.throttled_time = std::chrono::nanoseconds(throttled_ns_.load());
+    return stats;
+  }
+
+  void SetIncomingLimits(size_t max_pending_msgs,
+                         std::shared_ptr<BackpressureGate> shared_gate) {
+    // Receive side backpressure: the connection stops reading while it has
+    // max_pending_msgs (0: unlimited) messages that are not consumed yet, or
+    // while the shared gate (e.g. of all connections of a server) is
+    // saturated. The consumer reports every processed message with
+    // MessageConsumed(). CAUTION: must be called before the connection reads
+    // and the connection must be owned by a shared_ptr
+    if (max_pending_msgs > 0) {
+      incoming_gate_ = std::make_shared<BackpressureGate>(max_pending_msgs);
+    }
+    shared_incoming_gate_ = std::move(shared_gate);
+  }
+
+  void MessageConsumed() {
+    // can be called from every thread, once per message that was handed to
+    // the incoming sink
+    if (incoming_gate_) {
+      incoming_gate_->consumed();
+    }
+    if (shared_incoming_gate_) {
+      shared_incoming_gate_->consumed();
+    }
+  }
+
+  struct BackpressureStats {
+    uint64_t num_pauses = 0; // how often the consumer was too slow
+    std::chrono::nanoseconds paused_time{0}; // sum of all pauses
+    size_t pending_msgs = 0; // handed to the sink, but not consumed yet
+  };
+
+  BackpressureStats getBackpressureStats() const {
+    // can be called from every thread (a running pause is not included)
+    BackpressureStats stats;
+    stats.num_pauses = num_backpressure_pauses_.load();
+    stats.paused_time = std::chrono::nanoseconds(backpressure_ns_.load());
+    stats.pending_msgs = incoming_gate_ ? incoming_gate_->pending() : 0;
+    return stats;
+  }
+
   void AddToIncomingMsgQueue() {
+    // the received message is moved into the queue, so its payload is not
+    // copied. tmp_input_msg_ is refilled by the next parsed message anyway
+    if (tmp_input_msg_.header.flags & kControlFlags) {
+      // control frames are answered by the connection itself
+      if (tmp_input_msg_.header.flags & kFlagHeartbeatRequest) {
+        QueueMessage(controlMessage(kFlagHeartbeatReply),
+                     MessagePriority::High);
+      }
+      return;
+    }
+
+    if (incoming_gate_) {
+      incoming_gate_->added();
+    }
+    if (shared_incoming_gate_) {
+      shared_incoming_gate_->added();
+    }
+
     if (owner_ == Owner::server) {
-      in_msg_queue_.pushBack(
+      in_msg_queue_push_(
           {this->shared_from_this(),
-           tmp_input_msg_}); // Transform the incoming message to an owned
-                             // message if the owner of the connection interface
-                             // instance is a server implicitly calls the
-                             // initializer list
+           std::move(tmp_input_msg_)}); // Transform the incoming message to an
+                                        // owned message if the owner of the
+                                        // connection interface instance is a
+                                        // server implicitly calls the
+                                        // initializer list
     } else {
       // The owner is a client
-      in_msg_queue_.pushBack({nullptr, tmp_input_msg_});
+      in_msg_queue_push_({nullptr, std::move(tmp_input_msg_)});
       // no owner pointer required, since clients only have one communication
       // partner
     }
-
-    ReadHeader(); // prime the asynchronous asio I/O service object to read
-                  // another header --> register a new I/O service / I/O object
-                  // in the io_service object
   }
 
   // Async asio tasks
-  void ReadHeader() {
+  void ReadFrames() {
     /*
-     * We want to prime the I/O service object with the ReadHeader() method, in
+     * We want to prime the I/O service object with the ReadFrames() method, in
      * order to let the server/client listen for new messages (but we do not
-     * know WHEN the message will be available)
+     * know WHEN the message will be available). Instead of reading exactly one
+     * header and then exactly one payload, we read as many bytes as the socket
+     * has available into the free space of the receive ring buffer, so one
+     * system call (and one handler) can deliver many messages at once
      */
-    boost::asio::async_read(
-        socket_connection_,
-        boost::asio::buffer(&tmp_input_msg_.header, sizeof(message_header<T>)),
-        [this](boost::system::error_code ec, std::size_t length) {
+    socket_connection_.async_read_some(
+        in_buffer_.prepare(),
+        [this, self = keepAlive()](boost::system::error_code ec,
+                                   std::size_t length) {
           if (!ec) {
-            if (tmp_input_msg_.header.size >
-                0) { // We do not have always a payload attached to our headers,
-                     // so we need to check if there is a payload (which is
-                     // indicated by a saved size in the header, that is greater
-                     // then 0)
-              tmp_input_msg_.payload.resize(
-                  tmp_input_msg_.header
-                      .size); // resize the storage for the payload where the
-                              // received data from the socket should be stored
-              ReadPayload();
-            } else {
-              // if we do not have a payload attached, the read out of the
-              // socket is already complete and we will add the readed header to
-              // our message (thread save) queue
-              AddToIncomingMsgQueue(); // this method accesses the
-                                       // tmp_input_msg_ member variable to add
-                                       // the readed data to the queue
-            }
-
+            in_buffer_.commit(length);
+            last_receive_time_ = std::chrono::steady_clock::now();
+            ParseFrames(); // hand out all complete messages and read again
           } else {
-            std::cout << "[" << id_ << "]: reading the header failed!\n";
-            socket_connection_
-                .close(); // closing the connection will be detected by the
-                          // MessageClient or MessageAllClients function of the
-                          // server base class which will result in deleting the
-                          // connection object in the future
+            std::cout << "[" << id_ << "]: reading from the socket failed!\n";
+            CloseAfterReadError(); // closing the connection will be detected
+                                   // by the MessageClient or MessageAllClients
+                                   // function of the server base class which
+                                   // will result in deleting the connection
+                                   // object in the future
           }
         }); // Boost read handler
   }
 
-  void ReadPayload() {
+  void ParseFrames() {
+    /*
+     * Extract every complete message (header + payload) out of the receive
+     * ring buffer and add it to the incoming message queue. Incomplete
+     * messages stay within the ring buffer until the next ReadFrames() call
+     * has received the rest of them
+     */
+    bool rate_limited =
+        !receive_msg_bucket_.unlimited() || !receive_byte_bucket_.unlimited();
+    if (rate_limited) {
+      auto now = std::chrono::steady_clock::now();
+      receive_msg_bucket_.refill(now);
+      receive_byte_bucket_.refill(now);
+    }
+
+    while (in_buffer_.size() >= sizeof(message_header<T>)) {
+      if (PauseForBackpressure()) {
+        return; // ParseFrames() continues when the consumer caught up
+      }
+      if (rate_limited &&
+          (receive_msg_bucket_.empty() || receive_byte_bucket_.empty())) {
+        // the sender is too fast: stop reading until the buckets are refilled
+        // (the messages that are already received wait within the ring
+        // buffer)
+        PauseReading();
+        return;
+      }
+
+      // peek at the header without consuming it, since the payload of the
+      // message might not be completely received yet
+      message_header<T> header;
+      boost::asio::buffer_copy(
+          boost::asio::buffer(&header, sizeof(message_header<T>)),
+          in_buffer_.data());
+      size_t prefix_bytes =
+          (header.flags & kFlagFirstFragment) ? sizeof(uint32_t) : 0;
+      if (header.size > maxFramePayload() || header.size < prefix_bytes) {
+        CloseOnProtocolError("invalid frame size");
+        return;
+      }
+      size_t frame_bytes = sizeof(message_header<T>) + header.size;
+      bool read_directly = frame_bytes > in_buffer_.capacity();
+      if (in_buffer_.size() < sizeof(message_header<T>) + prefix_bytes ||
+          (!read_directly && in_buffer_.size() < frame_bytes)) {
+        break; // wait for the rest of the message
+      }
+
+      if (rate_limited) {
+        // the frame is taken out of the buckets as soon as it is certain that
+        // it is processed now (large frames are read right below)
+        receive_msg_bucket_.consume(1);
+        receive_byte_bucket_.consume(double(frame_bytes));
+      }
+
+      in_buffer_.consume(sizeof(message_header<T>));
+      size_t chunk_bytes = header.size;
+      uint8_t *target = PrepareFrameTarget(header, chunk_bytes);
+      if (target == nullptr) {
+        return; // protocol error, the connection is closed
+      }
+      size_t received_bytes = boost::asio::buffer_copy(
+          boost::asio::buffer(target, chunk_bytes), in_buffer_.data());
+      in_buffer_.consume(received_bytes);
+
+      if (received_bytes < chunk_bytes) {
+        // the frame will never fit into the ring buffer, so the rest of it is
+        // read directly into the storage of the message
+        ReadPayload(target + received_bytes, chunk_bytes - received_bytes,
+                    header.flags);
+        return;
+      }
+      if (!CompleteFrame(header.flags)) {
+        return;
+      }
+    }
+
+    ReadFrames(); // prime the asynchronous asio I/O service object to read
+                  // more data --> register a new I/O service / I/O object in
+                  // the io_service object
+  }
+
+  void PauseReading() {
+    // resume parsing (and reading) as soon as both buckets have tokens again
+    auto pause = std::max(receive_msg_bucket_.timeUntilAvailable(),
+                          receive_byte_bucket_.timeUntilAvailable());
+    if (!throttle_timer_) {
+      throttle_timer_ =
+          std::make_unique<boost::asio::steady_timer>(io_service_object_);
+    }
+    read_paused_ = true;
+    num_throttle_pauses_++;
+    auto pause_start = std::chrono::steady_clock::now();
+    throttle_timer_->expires_after(pause);
+    throttle_timer_->async_wait(
+        [this, self = keepAlive(), pause_start](boost::system::error_code ec) {
+          if (ec) {
+            return; // the I/O service object is shut down
+          }
+          read_paused_ = false;
+          throttled_ns_ += uint64_t(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - pause_start)
+                  .count());
+          if (socket_connection_.is_open()) {
+            ParseFrames();
+          } else {
+            CloseAfterReadError(); // closed during the pause
+          }
+        });
+  }
+
+  bool PauseForBackpressure() {
+    // stops reading if one of the incoming gates is saturated. Returns false
+    // if the connection can go on
+    BackpressureGate *gate = nullptr;
+    if (incoming_gate_ && incoming_gate_->saturated()) {
+      gate = incoming_gate_.get();
+    } else if (shared_incoming_gate_ && shared_incoming_gate_->saturated()) {
+      gate = shared_incoming_gate_.get();
+    } else {
+      return false;
+    }
+
+    auto pause_start = std::chrono::steady_clock::now();
+    std::weak_ptr<ConnectionInterface<T>> weak_self = this->weak_from_this();
+    read_paused_ = true;
+    bool paused = gate->waitForCapacity([this, weak_self, pause_start]() {
+      // called by the consuming thread, the parsing continues within the I/O
+      // service object
+      if (auto self = weak_self.lock()) {
+        boost::asio::post(io_service_object_, [this, self, pause_start]() {
+          read_paused_ = false;
+          backpressure_ns_ += uint64_t(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - pause_start)
+                  .count());
+          if (socket_connection_.is_open()) {
+            ParseFrames();
+          } else {
+            CloseAfterReadError(); // closed during the pause
+          }
+        });
+      }
+    });
+    if (!paused) {
+      read_paused_ = false; // the consumer caught up in the meantime
+      return false;
+    }
+    num_backpressure_pauses_++;
+    return true;
+  }
+
+  static TokenBucket makeBucket(double rate_per_second, double burst_seconds) {
+    // the bucket holds at least one message/byte
+    return TokenBucket(rate_per_second,
+                       std::max(rate_per_second * burst_seconds, 1.0));
+  }
+
+  uint8_t *PrepareFrameTarget(const message_header<T> &header,
+                              size_t &chunk_bytes) {
+    /*
+     * Returns where the payload of the frame (whose header was just consumed)
+     * has to be stored: a normal message is stored within tmp_input_msg_, a
+     * fragment within the message that is being reassembled. Returns nullptr
+     * (and closes the connection) if the frame violates the protocol
+     */
+    if (!(header.flags & kFlagFragment)) {
+      tmp_input_msg_.header = header;
+      tmp_input_msg_.payload.resize(header.size);
+      return tmp_input_msg_.payload.data();
+    }
+
+    if (header.flags & kFlagFirstFragment) {
+      uint32_t message_size = 0;
+      boost::asio::buffer_copy(
+          boost::asio::buffer(&message_size, sizeof(uint32_t)),
+          in_buffer_.data());
+      in_buffer_.consume(sizeof(uint32_t));
+      chunk_bytes -= sizeof(uint32_t);
+      if (reassembling_ || message_size > config_.max_message_bytes) {
+        CloseOnProtocolError("invalid first fragment");
+        return nullptr;
+      }
+      // the complete message is allocated at once, the fragments are written
+      // directly into it
+      reassembly_msg_.header = header; // keeps the correlation id
+      reassembly_msg_.header.size = message_size;
+      reassembly_msg_.header.flags &= ~kFragmentFlags;
+      reassembly_msg_.payload.resize(message_size);
+      reassembly_offset_ = 0;
+      reassembling_ = true;
+    }
+
+    if (!reassembling_ || header.id != reassembly_msg_.header.id ||
+        reassembly_offset_ + chunk_bytes > reassembly_msg_.payload.size()) {
+      CloseOnProtocolError("invalid fragment");
+      return nullptr;
+    }
+    uint8_t *target = reassembly_msg_.payload.data() + reassembly_offset_;
+    reassembly_offset_ += chunk_bytes;
+    return target;
+  }
+
+  bool CompleteFrame(uint32_t flags) {
+    // hands out the message after its (last) frame has been received. Returns
+    // false if the frame violated the protocol
+    if (!(flags & kFlagFragment)) {
+      AddToIncomingMsgQueue(); // this method accesses the tmp_input_msg_
+                               // member variable to add the readed data to the
+                               // queue
+      return true;
+    }
+    if (!(flags & kFlagLastFragment)) {
+      return true; // wait for the next fragment
+    }
+    if (reassembly_offset_ != reassembly_msg_.payload.size()) {
+      CloseOnProtocolError("the fragments do not match the message size");
+      return false;
+    }
+    reassembling_ = false;
+    tmp_input_msg_ = std::move(reassembly_msg_);
+    reassembly_msg_.payload.clear();
+    AddToIncomingMsgQueue();
+    return true;
+  }
+
+  void CloseAfterReadError() {
+    // Every close of the socket (by the partner, a failed write, a protocol
+    // error or Disconnect()) makes the pending read fail, so this is where the
+    // connection notices that it is closed
+    boost::system::error_code ec;
+    socket_connection_.close(ec);
+    if (close_handler_) {
+      std::function<void()> close_handler = std::move(close_handler_);
+      close_handler_ = nullptr; // called once
+      close_handler();
+    }
+  }
+
+  void CloseOnProtocolError(const char *reason) {
+    std::cout << "[" << id_ << "]: " << reason << ", closing the connection.\n";
+    boost::system::error_code ec;
+    socket_connection_.close(ec);
+  }
+
+  size_t maxFramePayload() const {
+    // a first fragment needs room for the message size and some payload
+    return std::max(config_.max_frame_bytes, kMinFramePayloadBytes);
+  }
+
+  void ReadPayload(uint8_t *target, size_t remaining_bytes, uint32_t flags) {
+    // reads the remaining payload of a frame that is larger than the receive
+    // ring buffer directly into the storage of the message
     boost::asio::async_read(
-        socket_connection_,
-        boost::asio::buffer(tmp_input_msg_.payload.data(),
-                            tmp_input_msg_.payload.size()),
-        [this](boost::system::error_code ec, std::size_t length) {
+        socket_connection_, boost::asio::buffer(target, remaining_bytes),
+        [this, self = keepAlive(), flags](boost::system::error_code ec,
+                                          std::size_t length) {
           // Another read handler
           if (!ec) {
-            AddToIncomingMsgQueue(); // accesses implicitly the tmp_input_msg
-                                     // and adds its content to the thread save
-                                     // incoming message queue
+            last_receive_time_ = std::chrono::steady_clock::now();
+            if (CompleteFrame(flags)) {
+              ParseFrames(); // continue with the (empty) ring buffer
+            }
           } else {
             std::cout << "[" << id_ << "]: reading the payload failed!\n";
-            socket_connection_.close();
+            CloseAfterReadError();
           }
         });
   }
 
-  void WriteHeader() {
+  void WriteMessages() {
+    /*
+     * Write all messages that are queued at the moment with ONE asynchronous
+     * write operation. The headers and payloads of the messages are handed
+     * over to boost::asio as one scatter/gather buffer sequence, so the OS
+     * receives them within a single (vectored) system call instead of one
+     * call per message. The batch is capped by the byte and buffer limits of
+     * the connection config, but it always contains at least one frame.
+     * Messages that are larger than the maximum frame size are split into
+     * fragments, which reference the payload of the shared message (no copy).
+     * Every frame is taken from the priority lane first, so a high priority
+     * message only waits for the write that is in progress
+     */
+    size_t batch_bytes = 0;
+    size_t batch_buffers = 0;
+    while (hasQueuedMessages()) {
+      bool priority = !out_priority_queue_.empty();
+      std::deque<SharedMessage<T>> &lane =
+          priority ? out_priority_queue_ : out_msg_queue_;
+      const SharedMessage<T> &msg_to_write = lane.front();
+      OutboundFrame frame{msg_to_write, msg_to_write->header, 0, 0,
+                          msg_to_write->payload.size()};
+      bool fragmented = !priority && frame.length > maxFramePayload();
+      size_t frame_buffers = 1; // the header
+      if (fragmented) {
+        // the next fragment of the message at the front of the queue
+        bool first = out_fragment_offset_ == 0;
+        size_t prefix_bytes = first ? sizeof(uint32_t) : 0;
+        frame.message_size = uint32_t(msg_to_write->payload.size());
+        frame.offset = out_fragment_offset_;
+        frame.length = std::min(maxFramePayload() - prefix_bytes,
+                                frame.length - out_fragment_offset_);
+        bool last = frame.offset + frame.length == frame.message_size;
+        frame.header.size = uint32_t(prefix_bytes + frame.length);
+        frame.header.flags |= kFlagFragment |
+                              (first ? kFlagFirstFragment : 0) |
+                              (last ? kFlagLastFragment : 0);
+        frame_buffers += first ? 1 : 0; // the total size of the message
+      }
+      frame_buffers += frame.length > 0 ? 1 : 0; // the payload
+      size_t frame_bytes = sizeof(message_header<T>) + frame.header.size;
+      if (!out_frame_batch_.empty() &&
+          ((batch_bytes + frame_bytes > config_.max_write_batch_bytes) ||
+           (batch_buffers + frame_buffers > config_.max_write_batch_buffers))) {
+        break; // the rest of the queue is written by the next batch
+      }
+      batch_bytes += frame_bytes;
+      batch_buffers += frame_buffers;
+
+      if (fragmented && !(frame.header.flags & kFlagLastFragment)) {
+        // the message stays at the front of the queue until its last
+        // fragment is written
+        out_fragment_offset_ += frame.length;
+        out_frame_batch_.emplace_back(std::move(frame));
+        continue;
+      }
+      // the batch keeps the messages alive until the write has completed,
+      // since boost::asio only holds references to their memory
+      out_queue_bytes_ -= frameBytes(*msg_to_write);
+      if (fragmented) {
+        out_fragment_offset_ = 0; // the last fragment of the message
+      }
+      out_frame_batch_.emplace_back(std::move(frame));
+      lane.pop_front();
+    }
+
+    // the buffers point into the frames, so they are created after the batch
+    // is complete
+    for (const OutboundFrame &frame : out_frame_batch_) {
+      out_write_buffers_.emplace_back(
+          boost::asio::buffer(&frame.header, sizeof(message_header<T>)));
+      if (frame.header.flags & kFlagFirstFragment) {
+        out_write_buffers_.emplace_back(
+            boost::asio::buffer(&frame.message_size, sizeof(uint32_t)));
+      }
+      if (frame.length > 0) {
+        out_write_buffers_.emplace_back(boost::asio::buffer(
+            frame.msg->payload.data() + frame.offset, frame.length));
+      }
+    }
+
+    num_writes_++;
+    num_written_frames_ += out_frame_batch_.size();
     boost::asio::async_write(
-        socket_connection_,
-        boost::asio::buffer(&out_msg_queue_.front().header,
-                            sizeof(message_header<T>)),
-        [this](boost::system::error_code ec, std::size_t length) {
+        socket_connection_, out_write_buffers_,
+        [this, self = keepAlive()](boost::system::error_code ec,
+                                   std::size_t length) {
           // boost::asio write handler
           if (!ec) {
+            out_frame_batch_.clear();
+            out_write_buffers_.clear();
 
-            if (out_msg_queue_.front().payload.size() > 0) {
-              // The message that we want to asynchronously send has a payload
-              // attached
-              writePayload();
+            if (hasQueuedMessages()) {
+              // if there are more messages to send in the queue, prime the
+              // boost::asio I/O service object (io_service) with another
+              // asynchronous task (i.e. I/O service / I/O object)
+              WriteMessages();
             } else {
-              // The message that we want to asynchronously send has NO payload
-              // attached
-              out_msg_queue_.popFront();
-
-              // check if there are more messages to send or if the queue of
-              // messages that should get sent is empty
-              if (!out_msg_queue_.isEmpty()) {
-                WriteHeader();
-              }
+              out_queue_full_reported_ = false; // the partner caught up
             }
 
           } else {
             // The connection has failed
-            std::cout << "[" << id_ << "]: sending the header failed!\n";
+            std::cout << "[" << id_ << "]: Writing the messages failed.\n";
             socket_connection_.close();
           }
         });
   }
 
-  void writePayload() {
-    boost::asio::async_write(
-        socket_connection_,
-        boost::asio::buffer(out_msg_queue_.front().payload.data(),
-                            out_msg_queue_.front().payload.size()),
-        [this](boost::system::error_code ec, std::size_t length) {
-          // write handler
-          if (!ec) {
-            out_msg_queue_.popFront();
+  static size_t frameBytes(const message<T> &msg) {
+    // number of bytes of the message on the wire
+    return sizeof(message_header<T>) + msg.payload.size();
+  }
 
-            if (!out_msg_queue_.isEmpty()) {
-              // if there are more messages to send in the queue, prime the
-              // boost::asio I/O service object (io_service) with another
-              // asynchronous task (i.e. I/O service / I/O object)
-              WriteHeader();
-            }
+  bool OutQueueExceeded(size_t additional_msgs, size_t additional_bytes,
+                        bool priority_lane) const {
+    // the marks of the whole queue count both lanes, the priority lane has
+    // its own mark on top
+    return (config_.max_out_queue_messages > 0 &&
+            OutQueueSize() + additional_msgs >
+                config_.max_out_queue_messages) ||
+           (config_.max_out_queue_bytes > 0 &&
+            out_queue_bytes_ + additional_bytes >
+                config_.max_out_queue_bytes) ||
+           (priority_lane && config_.max_out_priority_messages > 0 &&
+            out_priority_queue_.size() + additional_msgs >
+                config_.max_out_priority_messages);
+  }
 
-          } else {
-            std::cout << "[" << id_ << "]: Writing the payload failed.\n";
-            socket_connection_.close();
-          }
-        });
+  bool AdmitToOutQueue(const SharedMessage<T> &msg_to_send, size_t msg_bytes,
+                       bool priority_lane) {
+    /*
+     * Applies the out queue policy if the new message would exceed a
+     * high-water mark. Returns true if the message should be added to the
+     * given lane
+     */
+    if (!OutQueueExceeded(1, msg_bytes, priority_lane)) {
+      return true;
+    }
+
+    if (!out_queue_full_reported_) {
+      out_queue_full_reported_ = true;
+      if (out_queue_full_handler_) {
+        // posted instead of called, since the caller of QueueMessage() may
+        // hold locks that the handler needs (e.g. a broadcast of the server
+        // holds the connections mutex of the shard)
+        boost::asio::post(io_service_object_, out_queue_full_handler_);
+      }
+    }
+
+    if (config_.out_queue_policy != OutQueuePolicy::Disconnect &&
+        config_.max_out_queue_bytes > 0 &&
+        msg_bytes > config_.max_out_queue_bytes) {
+      // the message alone exceeds the mark, dropping (or replacing) queued
+      // messages can not make room for it
+      num_out_dropped_++;
+      return false;
+    }
+
+    std::deque<SharedMessage<T>> &lane =
+        priority_lane ? out_priority_queue_ : out_msg_queue_;
+    switch (config_.out_queue_policy) {
+    case OutQueuePolicy::DropNewest: {
+      num_out_dropped_++;
+      return false;
+    }
+
+    case OutQueuePolicy::Disconnect: {
+      std::cout << "[" << id_ << "]: out queue is full, disconnecting.\n";
+      num_out_dropped_++;
+      boost::system::error_code ec;
+      socket_connection_.close(ec);
+      return false;
+    }
+
+    case OutQueuePolicy::CoalesceById: {
+      // replace the newest queued message with the same id within the same
+      // lane (this scans the lane, but only while the partner is too slow)
+      for (auto it = lane.rbegin(); it != lane.rend(); ++it) {
+        if ((*it)->header.id == msg_to_send->header.id &&
+            !((*it)->header.flags & kControlFlags) &&
+            (priority_lane || !isPartiallyWritten(it.base() - 1))) {
+          out_queue_bytes_ -= frameBytes(**it);
+          out_queue_bytes_ += msg_bytes;
+          *it = msg_to_send;
+          num_out_coalesced_++;
+          return false; // the message is already within the queue
+        }
+      }
+      [[fallthrough]]; // nothing to coalesce with
+    }
+
+    case OutQueuePolicy::DropOldest:
+    default: {
+      // normal messages make room for every new message, queued high
+      // priority messages only for a new high priority message
+      DropOldestWhileExceeded(out_msg_queue_, msg_bytes, false);
+      if (priority_lane) {
+        DropOldestWhileExceeded(out_priority_queue_, msg_bytes, true);
+      }
+      if (OutQueueExceeded(1, msg_bytes, priority_lane)) {
+        // the messages that stay within the queue leave no room for the new
+        // one
+        num_out_dropped_++;
+        return false;
+      }
+      return true;
+    }
+    }
+  }
+
+  void DropOldestWhileExceeded(std::deque<SharedMessage<T>> &lane,
+                               size_t msg_bytes, bool priority_lane) {
+    // drops messages of the lane from the front until the new message fits
+    // (or nothing that may be dropped is left)
+    auto it = lane.begin();
+    while (it != lane.end() && OutQueueExceeded(1, msg_bytes, priority_lane)) {
+      if (((*it)->header.flags & kControlFlags) ||
+          (&lane == &out_msg_queue_ && isPartiallyWritten(it))) {
+        ++it; // control frames and a message whose first fragments are
+              // already written stay within the queue
+        continue;
+      }
+      out_queue_bytes_ -= frameBytes(**it);
+      it = lane.erase(it);
+      num_out_dropped_++;
+    }
+  }
+
+  bool hasQueuedMessages() const {
+    return !out_msg_queue_.empty() || !out_priority_queue_.empty();
+  }
+
+  bool isPartiallyWritten(
+      typename std::deque<SharedMessage<T>>::const_iterator it) const {
+    return it == out_msg_queue_.begin() && out_fragment_offset_ > 0;
+  }
+
+  static const SharedMessage<T> &controlMessage(uint32_t flags) {
+    // the control frames have no payload and are shared by all connections
+    static const SharedMessage<T> heartbeat_request =
+        makeControlMessage(kFlagHeartbeatRequest);
+    static const SharedMessage<T> heartbeat_reply =
+        makeControlMessage(kFlagHeartbeatReply);
+    return (flags == kFlagHeartbeatRequest) ? heartbeat_request
+                                            : heartbeat_reply;
+  }
+
+  static SharedMessage<T> makeControlMessage(uint32_t flags) {
+    message<T> control_msg;
+    control_msg.header.flags = flags;
+    return makeSharedMessage(std::move(control_msg));
   }
 
   // security methods
@@ -302,14 +963,15 @@ public:
     boost::asio::async_read(
         socket_connection_,
         boost::asio::buffer(&handshake_in_, sizeof(uint64_t)),
-        [this](boost::system::error_code ec, std::size_t length) {
+        [this, self = keepAlive()](boost::system::error_code ec,
+                                   std::size_t length) {
           if (!ec) {
             handshake_out_ = encrypt_handshake_data(
                 handshake_in_);   // calculate the puzzle on the client side
             SendValidationData(); // send the solved puzzle out to the server
           } else {
             std::cout << "Client disconnected (ReadServerValidationRequest)\n";
-            socket_connection_.close();
+            CloseAfterReadError();
           }
         });
   }
@@ -319,14 +981,21 @@ public:
     boost::asio::async_write(
         socket_connection_,
         boost::asio::buffer(&handshake_out_, sizeof(uint64_t)),
-        [this](boost::system::error_code ec, std::size_t length) {
+        [this, self = keepAlive()](boost::system::error_code ec,
+                                   std::size_t length) {
           if (!ec) {
             std::cout << "Sending the puzzle input to the client in order to "
                          "request the handshake.\n";
+            // messages that were queued during the handshake may be written
+            // now, their bytes can not get mixed up with the handshake data
+            validation_sent_ = true;
+            if (hasQueuedMessages() && out_frame_batch_.empty()) {
+              WriteMessages();
+            }
             if (owner_ == Owner::client) {
               // After the client send back the calculated validation data, we
               // want to listen for the server to talk with us
-              ReadHeader();
+              ReadFrames();
             }
           } else {
             socket_connection_.close();
@@ -334,14 +1003,15 @@ public:
         });
   }
 
-  void ReadAndCheckValidation(
-      custom_netlib::ServerInterfaceClass<T> *server = nullptr) {
+  template <typename ServerType>
+  void ReadAndCheckValidation(ServerType *server) {
     // ReadValidation()
     std::cout << "Checking if the client successfully solved the puzzle.\n";
     boost::asio::async_read(
         socket_connection_,
         boost::asio::buffer(&handshake_in_, sizeof(uint64_t)),
-        [this, server](boost::system::error_code ec, std::size_t length) {
+        [this, self = keepAlive(), server](boost::system::error_code ec,
+                                           std::size_t length) {
           if (!ec) {
             if (handshake_in_ == handshake_check_) {
               // success in validating the client
@@ -354,7 +1024,7 @@ public:
                                              // been validated
 
               // wait for new messages from the client
-              ReadHeader();
+              ReadFrames();
             } else {
               // This is what happens, if the connection could not be validated
               // (i.e. an attacker has failed to enter our system --> e.g.
@@ -365,7 +1035,7 @@ public:
             }
           } else {
             std::cout << "Client disconnected (ReadServerValidationRequest)\n";
-            socket_connection_.close();
+            CloseAfterReadError();
           }
         });
   }
@@ -378,22 +1048,76 @@ protected:
                            // just one I/O service object that manages all
                            // networking stuff, but especially the server can
                            // have multiple connection elements
-  TsNetQueue<message<T>> out_msg_queue_; // messages that should be send throu
-                                         // the socket connection
-  TsNetQueue<OwnedMessage<T>> &
-      in_msg_queue_; // messages that are received from the communication
-                     // partner of the network connection. Therefore, we need to
-                     // have the messages associated with the owner (i.e. the
-                     // communication partner on the other side) of the message
+  std::deque<SharedMessage<T>>
+      out_msg_queue_; // messages that should be send throu the socket
+                      // connection. Only accessed from within the I/O service
+                      // object
+  std::deque<SharedMessage<T>>
+      out_priority_queue_;     // high priority messages (and control frames),
+                               // written ahead of the out_msg_queue_
+  size_t out_queue_bytes_ = 0; // wire bytes of the messages within both lanes
+  std::function<void()> out_queue_full_handler_;
+  std::function<void()> close_handler_;
+  bool out_queue_full_reported_ = false;
+  std::atomic<uint64_t> num_out_dropped_{0};
+  std::atomic<uint64_t> num_out_coalesced_{0};
+  struct OutboundFrame {
+    SharedMessage<T> msg; // keeps the payload alive until the write completed
+    message_header<T> header; // header of the frame on the wire
+    uint32_t message_size;    // written after the header of a first fragment
+    size_t offset;            // part of the payload within the frame
+    size_t length;
+  };
+  std::vector<OutboundFrame>
+      out_frame_batch_; // frames of the write that is currently in progress.
+                        // Only accessed from within the I/O service object
+  size_t out_fragment_offset_ = 0; // payload bytes of the fragmented message
+                                   // at the front of the out queue that are
+                                   // already written
+  std::vector<boost::asio::const_buffer>
+      out_write_buffers_; // buffer sequence of the current write (reused
+                          // between the writes to avoid allocations)
+  std::atomic<uint64_t> num_writes_{0};
+  std::atomic<uint64_t> num_written_frames_{0};
+  IncomingSink
+      in_msg_queue_push_; // adds messages that are received from the
+                          // communication partner of the network connection
+                          // to the incoming queue of the owner. Therefore, we
+                          // need to have the messages associated with the owner
+                          // (i.e. the communication partner on the other side)
+                          // of the message
   Owner owner_ = Owner::server;
   uint32_t id_ = 0; // store the identifyer of the client associated with the
                     // connection object
   message<T> tmp_input_msg_;
+  message<T> reassembly_msg_; // fragmented message that is being received
+  size_t reassembly_offset_ = 0;
+  bool reassembling_ = false;
+  ConnectionConfig config_;
+  CircularBuffer in_buffer_; // receive ring buffer for the socket reads
 
   // handshake membervariables
   uint64_t handshake_out_;
   uint64_t handshake_in_;
   uint64_t handshake_check_;
+  std::chrono::steady_clock::time_point last_receive_time_ =
+      std::chrono::steady_clock::now(); // refreshed by every read
+  // rate limiting of the receive path
+  TokenBucket receive_msg_bucket_;
+  TokenBucket receive_byte_bucket_;
+  std::unique_ptr<boost::asio::steady_timer>
+      throttle_timer_; // only created if the connection is throttled
+  bool read_paused_ = false;
+  std::atomic<uint64_t> num_throttle_pauses_{0};
+  std::atomic<uint64_t> throttled_ns_{0};
+  // receive side backpressure (nullptr: unlimited)
+  std::shared_ptr<BackpressureGate> incoming_gate_;
+  std::shared_ptr<BackpressureGate> shared_incoming_gate_;
+  std::atomic<uint64_t> num_backpressure_pauses_{0};
+  std::atomic<uint64_t> backpressure_ns_{0};
+  bool validation_sent_ = false; // true after the own handshake data is
+                                 // written, before that the out queue is not
+                                 // written to the socket
 };
 
 } // namespace custom_netlib
@@ -7,9 +7,21 @@
 
 #include "common_net_includes.hpp"
 #include "connection_net_interface.hpp"
+#include "net_backpressure_gate.hpp"
+#include "net_circular_buffer.hpp"
 #include "net_client.hpp"
+#include "net_config.hpp"
+#include "net_connection_registry.hpp"
+#include "net_io_context_pool.hpp"
 #include "net_message.hpp"
+#include "net_message_dispatcher.hpp"
+#include "net_mpsc_queue.hpp"
+#include "net_payload_buffer.hpp"
 #include "net_server.hpp"
+#include "net_subscription_registry.hpp"
+#include "net_timer_wheel.hpp"
+#include "net_token_bucket.hpp"
 #include "net_ts_queue.hpp"
+#include "net_worker_pool.hpp"
 
 #endif /* CUSTOMNETLIB */
\ No newline at end of file
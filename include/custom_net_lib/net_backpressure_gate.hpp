@@ -0,0 +1,91 @@
+#ifndef BACKPRESSUREGATENET
+#define BACKPRESSUREGATENET
+
+#include "common_net_includes.hpp"
+
+namespace custom_netlib {
+
+/*
+ * Counts the received messages that wait for their consumer (e.g. within the
+ * incoming queue of the server) and tells the connections when to stop and
+ * when to continue reading. The gate is saturated at the high-water mark.
+ * A connection that finds the gate saturated registers a resume callback and
+ * stops reading. Once the consumers have brought the number of pending
+ * messages down to half of the mark, all callbacks are called (from within
+ * the consuming thread).
+ *
+ * added() and consumed() can be called from every thread. The callbacks must
+ * only post the actual work (e.g. to the I/O service object of the
+ * connection), since they run while the consumer is within consumed().
+ */
+class BackpressureGate {
+public:
+  using resume_callback = std::function<void()>;
+
+  explicit BackpressureGate(size_t high_water_mark)
+      : high_water_mark_(std::max<size_t>(high_water_mark, 1)),
+        resume_mark_(high_water_mark_ / 2) {}
+
+  BackpressureGate(const BackpressureGate &) = delete;
+
+  bool saturated() const { return pending_.load() >= high_water_mark_; }
+
+  void added(size_t num_msgs = 1) { pending_ += num_msgs; }
+
+  void consumed(size_t num_msgs = 1) {
+    size_t pending = pending_.fetch_sub(num_msgs) - num_msgs;
+    if (pending <= resume_mark_ && has_waiters_.load()) {
+      resumeAll();
+    }
+  }
+
+  bool waitForCapacity(resume_callback resume) {
+    // Returns false if the consumers already caught up (the caller continues
+    // right away), otherwise the callback is called once they did
+    std::unique_lock<std::mutex> lck(mtx_);
+    waiters_.emplace_back(std::move(resume));
+    // announce the waiter BEFORE the pending messages are checked again: a
+    // consumer either sees the waiter or this check sees its consumption
+    has_waiters_.store(true);
+    if (pending_.load() <= resume_mark_) {
+      waiters_.pop_back();
+      has_waiters_.store(!waiters_.empty());
+      return false;
+    }
+    num_pauses_++;
+    return true;
+  }
+
+  size_t pending() const { return pending_.load(); }
+  uint64_t numPauses() const { return num_pauses_.load(); }
+
+  size_t numWaiting() {
+    std::unique_lock<std::mutex> lck(mtx_);
+    return waiters_.size();
+  }
+
+private:
+  void resumeAll() {
+    std::vector<resume_callback> waiters;
+    {
+      std::unique_lock<std::mutex> lck(mtx_);
+      waiters.swap(waiters_);
+      has_waiters_.store(false);
+    }
+    for (resume_callback &resume : waiters) {
+      resume();
+    }
+  }
+
+  const size_t high_water_mark_;
+  const size_t resume_mark_;
+  std::atomic<size_t> pending_{0};
+  std::atomic<bool> has_waiters_{false};
+  std::atomic<uint64_t> num_pauses_{0};
+  std::mutex mtx_; // protects the waiters
+  std::vector<resume_callback> waiters_;
+};
+
+} // namespace custom_netlib
+
+#endif /* BACKPRESSUREGATENET */
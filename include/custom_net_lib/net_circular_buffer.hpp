@@ -0,0 +1,108 @@
+#ifndef CIRCULARBUFFERNET
+#define CIRCULARBUFFERNET
+
+#include "common_net_includes.hpp"
+
+#include <boost/container/static_vector.hpp>
+#include <stdexcept>
+
+namespace custom_netlib {
+
+/*
+ * Fixed size byte ring buffer that is used as receive buffer of a connection.
+ * It follows the DynamicBuffer principle of boost::asio (prepare -> commit for
+ * the writing side, data -> consume for the reading side) like the
+ * CircularBuffer in
+ * other_ressources/async_io_with_cpp/tcp_echo_server_circularbuffer_multithreaded.cpp
+ * but its capacity is defined at runtime, since it is part of the
+ * ConnectionConfig.
+ *
+ * Since the stored bytes can wrap around the end of the underlying memory
+ * block, prepare() and data() return a sequence of up to two buffers that can
+ * directly be handed to the boost::asio read functions (readv) and to
+ * boost::asio::buffer_copy.
+ */
+class CircularBuffer {
+public:
+  using const_buffers_type =
+      boost::container::static_vector<boost::asio::const_buffer, 2>;
+  using mutable_buffers_type =
+      boost::container::static_vector<boost::asio::mutable_buffer, 2>;
+
+  explicit CircularBuffer(std::size_t capacity) : buffer_(capacity) {}
+
+  mutable_buffers_type prepare(std::size_t n) {
+    // returns the free memory for writing n bytes into the buffer
+    if (size() + n > capacity()) {
+      throw std::length_error("circular buffer overflow");
+    }
+    return makeSequence<mutable_buffers_type>(buffer_.data(), tail_,
+                                              tail_ + n);
+  }
+
+  mutable_buffers_type prepare() {
+    // returns all of the free memory of the buffer
+    return prepare(capacity() - size());
+  }
+
+  void commit(std::size_t n) {
+    // make the n bytes that were written into the prepared memory readable
+    tail_ += std::min(n, capacity() - size());
+  }
+
+  const_buffers_type data() const {
+    // read only view on all readable bytes
+    return makeSequence<const_buffers_type>(buffer_.data(), head_, tail_);
+  }
+
+  void consume(std::size_t n) {
+    // free the n bytes at the front of the readable data
+    head_ += std::min(n, size());
+    if (head_ == tail_) {
+      // rewind an empty buffer, so the next prepare() returns one contiguous
+      // memory block instead of two (less work for the OS within readv)
+      head_ = 0;
+      tail_ = 0;
+    }
+  }
+
+  std::size_t size() const { return tail_ - head_; }
+
+  std::size_t capacity() const { return buffer_.size(); }
+
+  bool full() const { return size() == capacity(); }
+
+private:
+  template <typename Sequence, typename Pointer>
+  static Sequence makeSequence(Pointer memory, std::size_t begin,
+                               std::size_t end, std::size_t capacity) {
+    std::size_t length = end - begin;
+    if (length == 0) {
+      return {};
+    }
+
+    begin %= capacity;
+    if (begin + length <= capacity) {
+      // flat case: the bytes do not wrap around the end of the memory block
+      return {typename Sequence::value_type(memory + begin, length)};
+    }
+    // looped case: the bytes continue at the front of the memory block
+    std::size_t ending = capacity - begin;
+    return {typename Sequence::value_type(memory + begin, ending),
+            typename Sequence::value_type(memory, length - ending)};
+  }
+
+  template <typename Sequence, typename Pointer>
+  Sequence makeSequence(Pointer memory, std::size_t begin,
+                        std::size_t end) const {
+    return makeSequence<Sequence>(memory, begin, end, capacity());
+  }
+
+  std::vector<uint8_t> buffer_;
+  std::size_t head_ = 0; // index of the first readable byte (not wrapped)
+  std::size_t tail_ = 0; // index behind the last readable byte (not wrapped)
+};
+
+} // namespace custom_netlib
+
+#endif /* CIRCULARBUFFERNET */
@@ -3,13 +3,41 @@
 
 #include "common_net_includes.hpp"
 #include "connection_net_interface.hpp"
+#include "net_config.hpp"
 #include "net_message.hpp"
+#include "net_message_dispatcher.hpp"
+#include "net_timer_wheel.hpp"
 #include "net_ts_queue.hpp"
 
+#include <future>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 
 namespace custom_netlib {
 
+// outcome of a request of the client
+enum class RequestStatus {
+  Ok,          // the response arrived
+  Timeout,     // no response within the timeout of the request
+  Disconnected // the client was not (or is no longer) connected
+};
+
+// exception of the future of a request that did not get its response
+class RequestFailed : public std::runtime_error {
+public:
+  explicit RequestFailed(RequestStatus status)
+      : std::runtime_error(status == RequestStatus::Timeout
+                               ? "the request timed out"
+                               : "the client is not connected"),
+        status_(status) {}
+
+  RequestStatus status() const { return status_; }
+
+private:
+  RequestStatus status_;
+};
+
 template <typename T> class ClientBaseInterface {
   /*
    * Client interface class that is responsible for setting up the connection as
@@ -18,7 +46,11 @@ template <typename T> class ClientBaseInterface {
 
 public:
   // elements of the rule of five
-  ClientBaseInterface() : connection_sock_(ioserv_) {
+  ClientBaseInterface(const ConnectionConfig &connection_config =
+                          ConnectionConfig())
+      : connection_sock_(ioserv_), connection_config_(connection_config),
+        request_timeouts_(ioserv_, kRequestTimeoutTick,
+                          kRequestTimeoutSlots) {
     // associate the I/O service object with the socker, so it can send it I/O
     // objects for execution
     std::cout << "The client I/O context is now active.\n";
@@ -44,7 +76,27 @@ public:
       connection_module_ = std::make_unique<ConnectionInterface<T>>(
           ConnectionInterface<T>::Owner::client, ioserv_,
           boost::asio::ip::tcp::socket(ioserv_),
-          input_message_queue_); // create an connection interface instance
+          typename ConnectionInterface<T>::IncomingSink(
+              [this](OwnedMessage<T> &&owned_msg) {
+                // responses go to their pending request, everything else to
+                // the incoming queue
+                if (owned_msg.msg.header.flags & kFlagResponse) {
+                  completeRequest(owned_msg.msg.header.correlation_id,
+                                  RequestStatus::Ok, std::move(owned_msg.msg));
+                  return;
+                }
+                if (message_callback_) {
+                  message_callback_(owned_msg.msg);
+                  return;
+                }
+                input_message_queue_.pushBack(std::move(owned_msg));
+              }),
+          connection_config_); // create an connection interface instance
+      connection_module_->SetCloseHandler([this]() {
+        // the server closed the connection (or it failed), so the pending
+        // requests will never get their response
+        failPendingRequests();
+      });
       connection_module_->ConnectToServer(
           endpts); // try to establish the connection with the connection
                    // instance
@@ -68,11 +120,19 @@ public:
 
     if (thr_io_serv_.joinable()) {
       thr_io_serv_.join();
+      // run the handlers that are already due (e.g. requests that were posted
+      // right before the stop), so none of them waits forever
+      ioserv_.restart();
+      ioserv_.poll();
     }
 
     connection_module_
         .release(); // release the unique pointer (this is the "manually go out
                     // of scope" for a unique_ptr)
+
+    // the I/O thread is gone, so the requests that still wait for their
+    // response are failed from here
+    failPendingRequests();
     std::cout << "Connection stoped!\n";
   }
 
@@ -93,13 +153,183 @@ public:
     return input_message_queue_;
   }
 
-  void Send(const message<T> &msg) {
+  template <typename Rep, typename Period>
+  bool waitForMessage(const std::chrono::duration<Rep, Period> &timeout) {
+    // Blocks until there is a message within the incoming queue (returns
+    // true) or the timeout has expired. The caller is woken up as soon as the
+    // message arrives, so there is no need to poll Incoming()
+    return input_message_queue_.waitFor(timeout);
+  }
+
+  void SetMessageCallback(std::function<void(message<T> &)> callback) {
+    // Event driven alternative to the incoming queue: every received message
+    // (except the responses to requests) is handed to the callback directly
+    // within the I/O thread of the client, right after it was parsed. The
+    // callback should be short, since the client does not read while it
+    // runs. CAUTION: must be called before Connect()
+    message_callback_ = std::move(callback);
+  }
+
+  MessageDispatcher<T> &messageHandlers() {
+    // Handlers per message id, called by update() with the message or with
+    // its decoded payload. CAUTION: only register them from within the thread
+    // that calls update()
+    return message_handlers_;
+  }
+
+  size_t update(size_t numMaxMessages = -1, bool enable_waiting = false) {
+    // Hands up to numMaxMessages received messages to their handlers (the
+    // messages without a handler are dropped) and returns their number. With
+    // enable_waiting, the call blocks until there is at least one message
+    if (enable_waiting) {
+      input_message_queue_.wait();
+    }
+
+    size_t msg_count = 0;
+    while (msg_count < numMaxMessages) {
+      size_t num_popped = input_message_queue_.popUpTo(
+          numMaxMessages - msg_count, update_batch_);
+      if (num_popped == 0) {
+        break;
+      }
+
+      for (auto &owned_msg : update_batch_) {
+        message_handlers_.dispatch(owned_msg.msg);
+      }
+      update_batch_.clear();
+      msg_count += num_popped;
+    }
+    return msg_count;
+  }
+
+  void Send(const message<T> &msg,
+            MessagePriority priority = MessagePriority::Normal) {
+    if (isConnected()) {
+      connection_module_->SendData(msg, priority);
+    }
+  }
+
+  void Send(message<T> &&msg,
+            MessagePriority priority = MessagePriority::Normal) {
+    if (isConnected()) {
+      connection_module_->SendData(std::move(msg), priority);
+    }
+  }
+
+  void Send(SharedMessage<T> msg,
+            MessagePriority priority = MessagePriority::Normal) {
     if (isConnected()) {
-      connection_module_->SendData(msg);
+      connection_module_->SendData(std::move(msg), priority);
     }
   }
 
+  // request/response
+  using ResponseCallback = std::function<void(RequestStatus, message<T> &&)>;
+
+  void Request(message<T> request, std::chrono::milliseconds timeout,
+               ResponseCallback on_response,
+               MessagePriority priority = MessagePriority::Normal) {
+    // Sends the request and calls on_response (within the I/O thread of the
+    // client) with the response that the server creates with makeResponse(),
+    // or with the reason why there is none. Any number of requests can be in
+    // flight at the same time, the responses may arrive in any order. A
+    // response that arrives after the timeout is dropped. If the client is
+    // not connected, on_response is called right away within the calling
+    // thread
+    if (!isConnected() || ioserv_.stopped()) {
+      on_response(RequestStatus::Disconnected, message<T>());
+      return;
+    }
+    uint32_t correlation_id = nextCorrelationId();
+    request.header.correlation_id = correlation_id;
+    boost::asio::post(
+        ioserv_, [this, correlation_id, timeout, priority,
+                  shared_request = makeSharedMessage(std::move(request)),
+                  on_response = std::move(on_response)]() mutable {
+          if (!isConnected()) {
+            on_response(RequestStatus::Disconnected, message<T>());
+            return;
+          }
+          // the pending requests are only accessed within the I/O thread,
+          // so they need no lock. The wheel only ticks while there are
+          // pending requests
+          request_timeouts_.start();
+          TimerWheel::timer_id timeout_id = request_timeouts_.schedule(
+              timeout, [this, correlation_id]() {
+                completeRequest(correlation_id, RequestStatus::Timeout,
+                                message<T>());
+              });
+          pending_requests_.emplace(
+              correlation_id,
+              PendingRequest{std::move(on_response), timeout_id});
+          connection_module_->QueueMessage(std::move(shared_request),
+                                           priority);
+        });
+  }
+
+  std::future<message<T>>
+  Request(message<T> request, std::chrono::milliseconds timeout,
+          MessagePriority priority = MessagePriority::Normal) {
+    // same as above, but the response is delivered through a future (which
+    // throws RequestFailed if there is no response)
+    auto promise = std::make_shared<std::promise<message<T>>>();
+    std::future<message<T>> response = promise->get_future();
+    Request(
+        std::move(request), timeout,
+        [promise](RequestStatus status, message<T> &&response_msg) {
+          if (status == RequestStatus::Ok) {
+            promise->set_value(std::move(response_msg));
+          } else {
+            promise->set_exception(
+                std::make_exception_ptr(RequestFailed(status)));
+          }
+        },
+        priority);
+    return response;
+  }
+
 private:
+  uint32_t nextCorrelationId() {
+    // 0 marks the messages that are no requests
+    uint32_t correlation_id = next_correlation_id_++;
+    return correlation_id != 0 ? correlation_id : next_correlation_id_++;
+  }
+
+  void failPendingRequests() {
+    // CAUTION: only within the I/O thread or after it has stopped
+    std::unordered_map<uint32_t, PendingRequest> pending_requests;
+    pending_requests.swap(pending_requests_);
+    for (auto &pending_request : pending_requests) {
+      request_timeouts_.cancel(pending_request.second.timeout_id);
+    }
+    request_timeouts_.stop();
+    for (auto &pending_request : pending_requests) {
+      pending_request.second.on_response(RequestStatus::Disconnected,
+                                         message<T>());
+    }
+  }
+
+  void completeRequest(uint32_t correlation_id, RequestStatus status,
+                       message<T> &&response) {
+    // the timeout and the response race for the request, the first one wins
+    auto it = pending_requests_.find(correlation_id);
+    if (it == pending_requests_.end()) {
+      return;
+    }
+    ResponseCallback on_response = std::move(it->second.on_response);
+    request_timeouts_.cancel(it->second.timeout_id); // releases its closure
+    pending_requests_.erase(it);
+    if (pending_requests_.empty()) {
+      request_timeouts_.stop(); // no wakeups of the idle I/O thread
+    }
+    on_response(status, std::move(response));
+  }
+
+  // resolution of the request timeouts, one revolution of the wheel covers
+  // ten seconds (longer timeouts take more rounds)
+  static constexpr std::chrono::milliseconds kRequestTimeoutTick{10};
+  static constexpr size_t kRequestTimeoutSlots = 1024;
+
   TsNetQueue<OwnedMessage<T>> input_message_queue_;
 
 protected:
@@ -121,6 +351,21 @@ protected:
       connection_module_; // instance of the clients connection module of the
                           // architecture overview
   boost::asio::ip::tcp::endpoint end_pt_to_connect_;
+  ConnectionConfig connection_config_; // tuning of the connection module
+  MessageDispatcher<T> message_handlers_;
+  std::function<void(message<T> &)>
+      message_callback_; // if set, replaces the incoming queue
+  std::deque<OwnedMessage<T>>
+      update_batch_; // messages that update() currently processes
+  struct PendingRequest {
+    ResponseCallback on_response;
+    TimerWheel::timer_id timeout_id;
+  };
+  std::unordered_map<uint32_t, PendingRequest>
+      pending_requests_; // correlation id -> callback, only accessed within
+                         // the I/O thread (or after it has stopped)
+  std::atomic<uint32_t> next_correlation_id_{1};
+  TimerWheel request_timeouts_; // timeouts of the pending requests
 };
 
 } // namespace custom_netlib
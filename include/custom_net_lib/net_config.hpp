@@ -0,0 +1,140 @@
+#ifndef NETCONFIG
+#define NETCONFIG
+
+#include "common_net_includes.hpp"
+
+namespace custom_netlib {
+
+// What a connection does with a new outgoing message if its out queue is at
+// the high-water mark (i.e. the communication partner does not read fast
+// enough)
+enum class OutQueuePolicy {
+  DropOldest,   // drop queued messages from the front until the new one fits
+  DropNewest,   // drop the new message
+  CoalesceById, // replace the queued message with the same id by the new one
+                // (e.g. state updates where only the latest one matters),
+                // otherwise drop the oldest
+  Disconnect    // close the connection
+};
+
+/*
+ * Tuning parameters of a single connection. The server hands its instance to
+ * every ConnectionInterface that it creates, the client uses its own instance
+ * for its connection to the server. The defaults are suitable for most
+ * applications.
+ */
+struct ConnectionConfig {
+  // Upper limits for one coalesced write of the outgoing message queue. All
+  // messages that are queued at the moment a write is started are written
+  // with one vectored async_write, as long as neither limit is exceeded (one
+  // message is always written, even if it is larger than the byte limit)
+  size_t max_write_batch_bytes = 64 * 1024;
+  size_t max_write_batch_buffers =
+      64; // every message needs two buffers (header and payload). 64 is the
+          // number of iovecs that boost::asio hands to one sendmsg() call
+
+  // Size of the receive ring buffer of the connection. Every read fills the
+  // free space of the ring buffer and all complete messages are handed out at
+  // once. Messages that are larger than the ring buffer are read directly into
+  // their own storage
+  size_t receive_buffer_bytes = 16 * 1024;
+
+  // Upper limit for the payload of one frame on the wire. Larger messages are
+  // split into fragments of this size and reassembled by the receiver, so a
+  // large message only occupies the socket for one frame at a time. A
+  // received frame that is larger closes the connection (a bogus header can
+  // not make the receiver allocate arbitrary amounts of memory). Values below
+  // 64 bytes are raised to 64
+  size_t max_frame_bytes = 64 * 1024;
+  // Upper limit for the payload of a reassembled message. The receiver
+  // allocates the complete message when its first fragment arrives, a larger
+  // announced size closes the connection
+  size_t max_message_bytes = 16 * 1024 * 1024;
+
+  // Rate limits for the messages that are received from the communication
+  // partner (0: unlimited). They are enforced with token buckets before a
+  // message is handed to the incoming queue: If a bucket is empty, the
+  // connection pauses reading (TCP backpressure slows the sender down) until
+  // the bucket is refilled. Nothing is dropped. The burst is the number of
+  // seconds worth of messages/bytes that may arrive at once after a quiet
+  // period
+  double max_receive_messages_per_second = 0;
+  double max_receive_bytes_per_second = 0;
+  double receive_burst_seconds = 1.0;
+
+  // High-water marks of the outgoing message queue (0: unlimited). If a new
+  // message would exceed one of them, the out queue policy decides what
+  // happens. Control frames (heartbeats) are never dropped. A message that
+  // alone exceeds the byte mark is dropped (or closes the connection with
+  // the Disconnect policy)
+  size_t max_out_queue_bytes = 0;
+  size_t max_out_queue_messages = 0;
+  // Both marks count the normal and the high priority messages. The high
+  // priority lane additionally holds at most max_out_priority_messages
+  // (0: unlimited), so a partner that keeps asking for high priority answers
+  // (e.g. pings) without reading them can not fill the queue with them
+  size_t max_out_priority_messages = 0;
+  OutQueuePolicy out_queue_policy = OutQueuePolicy::DropOldest;
+};
+
+/*
+ * Tuning parameters of the server. The connection config is handed to every
+ * connection that the server accepts.
+ */
+struct ServerConfig {
+  // Number of I/O threads. Every thread runs its own io_context and every
+  // connection is bound to one of them (round robin), so the handlers of one
+  // connection never run concurrently
+  size_t num_io_threads = 1;
+
+  // If true, every I/O thread gets its own acceptor on the same port
+  // (SO_REUSEPORT) and only serves the connections that it accepted itself.
+  // The kernel spreads the new connections over the acceptors, so there is no
+  // single accepting thread and no handoff of sockets between the threads.
+  // If false, the first I/O thread accepts all connections and hands them out
+  // round robin. Falls back to one acceptor if SO_REUSEPORT is not available
+  bool reuse_port_acceptors = false;
+
+  // Number of worker threads that call onMessage. With 0 workers, the
+  // messages are processed by the thread that calls update(). Otherwise the
+  // received messages go directly to the workers (update() is not needed):
+  // The messages of one client are always handled by the same worker (client
+  // ID % number of workers), so they stay in order
+  size_t num_message_workers = 0;
+
+  // Initial size of the message handler table (messageHandlers()), e.g. the
+  // number of enumerators of the message ids. The table grows with the
+  // registered ids anyway, the size only avoids its reallocations
+  size_t num_message_ids = 0;
+
+  // Receive side backpressure (0: unlimited). If the received messages that
+  // are not processed yet (within the incoming queue or the queues of the
+  // workers) reach max_incoming_messages, all connections stop reading. If
+  // one client has max_incoming_messages_per_client of them, only this client
+  // stops. The reading continues as soon as the number has dropped to half of
+  // the mark, meanwhile TCP flow control slows the clients down (instead of
+  // the memory of the server growing)
+  size_t max_incoming_messages = 0;
+  size_t max_incoming_messages_per_client = 0;
+
+  // Liveness of the connections (0 disables the check). If nothing was
+  // received from a client for heartbeat_interval, the server sends it a
+  // heartbeat request, which the ConnectionInterface of the client answers
+  // automatically. If nothing was received for idle_timeout, the connection is
+  // closed and reported through onClientDisconnect. The idle timeout should be
+  // a multiple of the heartbeat interval
+  std::chrono::milliseconds heartbeat_interval{0};
+  std::chrono::milliseconds idle_timeout{0};
+
+  // The checks run on one hashed timer wheel per I/O thread (instead of one
+  // timer per connection). The tick is the resolution of the timeouts, one
+  // revolution of the wheel should cover the longest timeout
+  std::chrono::milliseconds timer_wheel_tick{100};
+  size_t timer_wheel_slots = 512;
+
+  ConnectionConfig connection;
+};
+
+} // namespace custom_netlib
+
+#endif /* NETCONFIG */
@@ -0,0 +1,89 @@
+#ifndef CONNECTIONREGISTRYNET
+#define CONNECTIONREGISTRYNET
+
+#include "common_net_includes.hpp"
+#include "connection_net_interface.hpp"
+
+#include <unordered_map>
+
+namespace custom_netlib {
+
+/*
+ * Set of connections with O(1) lookup, insertion and removal by the client ID.
+ *
+ * The connections are stored densely within one vector (iterating over all
+ * connections for a broadcast touches one contiguous block of memory) and a
+ * hash map points from the client ID to the position within the vector. A
+ * removed connection is replaced by the last connection of the vector, so the
+ * order of the connections is NOT stable.
+ *
+ * Client IDs are never reused by the server, so a lookup with the ID of a
+ * client that already disconnected just finds nothing.
+ *
+ * The registry itself is not thread safe, the owner protects it.
+ */
+template <typename T> class ConnectionRegistry {
+public:
+  using connection_ptr = std::shared_ptr<ConnectionInterface<T>>;
+  using const_iterator = typename std::vector<connection_ptr>::const_iterator;
+
+  bool insert(uint32_t id, connection_ptr connection) {
+    // returns false if there is already a connection with the given ID
+    if (!index_by_id_.emplace(id, connections_.size()).second) {
+      return false;
+    }
+    connections_.emplace_back(std::move(connection));
+    ids_.emplace_back(id);
+    return true;
+  }
+
+  connection_ptr find(uint32_t id) const {
+    auto it = index_by_id_.find(id);
+    if (it == index_by_id_.end()) {
+      return nullptr;
+    }
+    return connections_[it->second];
+  }
+
+  bool erase(uint32_t id) {
+    auto it = index_by_id_.find(id);
+    if (it == index_by_id_.end()) {
+      return false;
+    }
+
+    // move the last connection into the gap, so the vector stays dense
+    size_t index = it->second;
+    size_t last_index = connections_.size() - 1;
+    if (index != last_index) {
+      connections_[index] = std::move(connections_[last_index]);
+      ids_[index] = ids_[last_index];
+      index_by_id_[ids_[index]] = index;
+    }
+    connections_.pop_back();
+    ids_.pop_back();
+    index_by_id_.erase(it);
+    return true;
+  }
+
+  void clear() {
+    connections_.clear();
+    ids_.clear();
+    index_by_id_.clear();
+  }
+
+  size_t size() const { return connections_.size(); }
+  bool empty() const { return connections_.empty(); }
+
+  const_iterator begin() const { return connections_.begin(); }
+  const_iterator end() const { return connections_.end(); }
+
+private:
+  std::vector<connection_ptr> connections_; // dense, in no particular order
+  std::vector<uint32_t> ids_; // client ID of the connection at the same index
+  std::unordered_map<uint32_t, size_t>
+      index_by_id_; // client ID -> index within connections_
+};
+
+} // namespace custom_netlib
+
+#endif /* CONNECTIONREGISTRYNET */
@@ -0,0 +1,80 @@
+#ifndef IOCONTEXTPOOLNET
+#define IOCONTEXTPOOLNET
+
+#include "common_net_includes.hpp"
+
+namespace custom_netlib {
+
+/*
+ * Pool of I/O service objects with one thread per I/O service object (like
+ * the IoContextGroup in
+ * other_ressources/async_io_with_cpp/tcp_echo_server_circularbuffer_multithreaded.cpp).
+ *
+ * Every connection is bound to exactly one io_context of the pool for its
+ * whole lifetime. Since every io_context is run by exactly one thread, the
+ * handlers of one connection never run concurrently (no strands or locks are
+ * needed within the ConnectionInterface), while different connections are
+ * processed on different cores.
+ */
+class IoContextPool {
+public:
+  using work_guard_type =
+      boost::asio::executor_work_guard<boost::asio::io_context::executor_type>;
+
+  explicit IoContextPool(size_t num_contexts) {
+    num_contexts = std::max<size_t>(num_contexts, 1);
+    for (size_t n = 0; n < num_contexts; n++) {
+      contexts_.emplace_back(std::make_unique<boost::asio::io_context>(1));
+      // the work guard keeps io_context::run() from returning while the
+      // io_context has nothing to do (e.g. no connection is assigned to it)
+      guards_.emplace_back(contexts_.back()->get_executor());
+    }
+  }
+
+  IoContextPool(const IoContextPool &) = delete;
+
+  ~IoContextPool() { stop(); }
+
+  void run() {
+    // start one thread per I/O service object (does not block the caller)
+    for (auto &io_context : contexts_) {
+      boost::asio::io_context *ctx = io_context.get();
+      threads_.emplace_back([ctx]() { ctx->run(); });
+    }
+  }
+
+  void stop() {
+    for (auto &io_context : contexts_) {
+      io_context->stop();
+    }
+    for (auto &thread : threads_) {
+      if (thread.joinable()) {
+        thread.join(); // wait/block the execution until the I/O service
+                       // object has successfully stopped
+      }
+    }
+    threads_.clear();
+  }
+
+  size_t queryIndex() {
+    // Get the index of the next I/O service object for a new connection by
+    // incooperating the round robin load balancing algorithm
+    return next_index_++ % contexts_.size();
+  }
+
+  boost::asio::io_context &query() { return *contexts_[queryIndex()]; }
+
+  boost::asio::io_context &at(size_t index) { return *contexts_[index]; }
+
+  size_t size() const { return contexts_.size(); }
+
+private:
+  std::vector<std::unique_ptr<boost::asio::io_context>> contexts_;
+  std::vector<work_guard_type> guards_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_index_{0};
+};
+
+} // namespace custom_netlib
+
+#endif /* IOCONTEXTPOOLNET */
@@ -2,6 +2,7 @@
 #define NETMESSAGE
 
 #include "common_net_includes.hpp"
+#include "net_payload_buffer.hpp"
 //#include "connection_net_interface.hpp" // We can not do this, since this
 // would be a cycle dependency - we solve this by commenting this line out and
 // then forward-declare the ConnectionInterface for the OwnedMessage struct
@@ -16,6 +17,35 @@ namespace custom_netlib {
  * message framework
  */
 
+// flags of the message header. Frames with one of the control flags are
+// handled by the ConnectionInterface itself and never reach the application
+constexpr uint32_t kFlagHeartbeatRequest = 1u << 0; // the receiver answers
+                                                    // with a heartbeat reply
+constexpr uint32_t kFlagHeartbeatReply = 1u << 1;
+constexpr uint32_t kControlFlags = kFlagHeartbeatRequest | kFlagHeartbeatReply;
+
+// A message whose payload is larger than the maximum frame size of the
+// connection is sent as several fragments with the id of the message. The
+// payload of the first fragment starts with the uint32_t size of the complete
+// payload, so the receiver allocates the message once instead of growing it.
+// The fragments of one message are never interleaved with the fragments of
+// another message
+constexpr uint32_t kFlagFragment = 1u << 2;
+constexpr uint32_t kFlagFirstFragment = 1u << 3;
+constexpr uint32_t kFlagLastFragment = 1u << 4;
+constexpr uint32_t kFragmentFlags =
+    kFlagFragment | kFlagFirstFragment | kFlagLastFragment;
+
+// The message answers the request with the same correlation id (see
+// makeResponse()). The client hands it to the pending request instead of its
+// incoming queue
+constexpr uint32_t kFlagResponse = 1u << 5;
+
+// Lane of the out queue of a connection that an outgoing message is queued in.
+// High priority messages (e.g. pings) are written at the next frame boundary,
+// ahead of all normal messages that are already queued
+enum class MessagePriority { Normal, High };
+
 // forward declaration for the header datatype, since it is used in the complete
 // message data structure
 template <typename T> struct message_header {
@@ -25,12 +55,13 @@ template <typename T> struct message_header {
                      /* Security issue:
                       *   If anything connects to the client or especially the server and sends it
                       * something that does not contain a valid header, the size variable of the
-                      * message header will receive a wrong number which results in allocating
-                      * unnecessary amounts of data which can be a whole lot of memory --> try to
-                      * connect to the server with putty and try to send it a
-                      * 1111111111111111111111111111111 message-After this, it will be the most
-                      * memory allocating process on your computer
+                      * message header will receive a wrong number which would result in
+                      * allocating a whole lot of memory. Therefore, the receiver closes the
+                      * connection if the size exceeds the max_frame_bytes of its
+                      * ConnectionConfig (and a fragmented message its max_message_bytes)
                       */
+  uint32_t flags = 0; // kFlag... bits, 0 for the messages of the application
+  uint32_t correlation_id = 0; // != 0 for requests and their responses
 }; // Remark: In structs, everything is public unless it is defined differend
    // (in opposite of classes, where everything is private by default)
 
@@ -42,23 +73,26 @@ template <typename T> struct message_header {
  *   msg_instance >> aimed_datatype_2 >> aimed_datatype_1;
  */
 
+// number of payload bytes that are stored within the message itself (no heap
+// allocation for pings and other small control messages)
+constexpr size_t kInlinePayloadBytes = 64;
+
 // actual message datastructure
 template <typename T> struct message {
   // data
   message_header<T> header{};
-  std::vector<uint32_t>
+  PayloadBuffer<kInlinePayloadBytes>
       payload; // the message has no notion of the datatype in the payload,
                // since it is a serialized form of the data that should be send.
-               // Therefore, for every serializabel datatype, uint32_t can be
-               // used
+               // Therefore, the payload is stored as plain bytes
 
   // methods
   size_t size() const {
     // making it const in order to make clear, that the size request should not
     // edit the data in the message
     return payload.size(); // sizeof(message_header<T>) + payload.size(); //
-                           // std::vector has a method called size, which
-                           // returns the number of bytes of the vector element
+                           // the payload buffer returns its size in bytes,
+                           // which is exactly what is sent over the network
   }
 
   // external access
@@ -99,11 +133,11 @@ template <typename T> struct message {
                            //      uint8_t
                            // explaination of msg.payload.data() + current_size:
                            //  msg.payload.data() gives us a pointer to the
-                           //  address of the first vector element back. Then we
-                           //  need to add the cached size in elements of the
-                           //  payload to get the pointer on which we want to
-                           //  add the new data and then copy the number of byes
-                           //  from the source data to the vector
+                           //  first byte of the payload back. Then we need to
+                           //  add the cached size in bytes of the payload to
+                           //  get the pointer on which we want to add the new
+                           //  data and then copy the number of byes from the
+                           //  source data to the payload
 
     msg.header.size =
         msg.size(); // update the size of the message in the header
@@ -140,6 +174,36 @@ template <typename T> struct message {
   }
 };
 
+/*
+ * Immutable, reference counted message that the outgoing message queues of the
+ * connections hold by reference. A message that should be sent to many
+ * clients (e.g. a broadcast) is serialized ONCE into a shared message and
+ * every connection writes from the same memory instead of its own deep copy.
+ */
+template <typename T> using SharedMessage = std::shared_ptr<const message<T>>;
+
+template <typename T>
+SharedMessage<T> makeSharedMessage(const message<T> &msg) {
+  return std::make_shared<const message<T>>(msg);
+}
+
+template <typename T> SharedMessage<T> makeSharedMessage(message<T> &&msg) {
+  // moves the payload into the shared message instead of copying it
+  return std::make_shared<const message<T>>(std::move(msg));
+}
+
+template <typename T> message<T> makeResponse(const message<T> &request) {
+  // Empty response to the request (the caller adds the payload). For a
+  // message that is not a request, this is a normal message with its id
+  message<T> response;
+  response.header.id = request.header.id;
+  response.header.correlation_id = request.header.correlation_id;
+  if (request.header.correlation_id != 0) {
+    response.header.flags = kFlagResponse;
+  }
+  return response;
+}
+
 // forward declaration
 template <typename T> class ConnectionInterface;
 
@@ -0,0 +1,96 @@
+#ifndef MESSAGEDISPATCHERNET
+#define MESSAGEDISPATCHERNET
+
+#include "common_net_includes.hpp"
+#include "net_message.hpp"
+
+#include <type_traits>
+
+namespace custom_netlib {
+
+/*
+ * Table of message handlers, indexed by the id of the message. Instead of a
+ * switch over header.id (or a virtual onMessage that contains one), every id
+ * gets its own handler within a flat vector, so dispatching a message is one
+ * bounds check and one indirect call. Handlers can be registered and replaced
+ * at any time, without subclassing the server or the client.
+ *
+ * The Context types are passed to every handler in front of the message
+ * (e.g. the connection of the client on the server side). A handler that is
+ * registered with onPayload() receives the payload decoded into a struct
+ * instead of the raw message. The struct is the only content of the message,
+ * exactly as it was written with operator<<. Messages with a different
+ * payload size are dropped and counted as malformed.
+ *
+ * CAUTION: The table itself is not thread safe. Handlers should be registered
+ * before the messages are dispatched, or from within the thread that
+ * dispatches them.
+ */
+template <typename T, typename... Context> class MessageDispatcher {
+public:
+  using handler_type = std::function<void(Context..., message<T> &)>;
+
+  explicit MessageDispatcher(size_t num_ids = 0) : handlers_(num_ids) {
+    // the table grows with the registered ids, num_ids (e.g. the number of
+    // enumerators of T) avoids the reallocations
+  }
+
+  MessageDispatcher(const MessageDispatcher &) = delete;
+
+  void on(T msg_id, handler_type handler) {
+    // registers (or replaces) the handler of the id, nullptr removes it
+    size_t index = size_t(msg_id);
+    if (index >= handlers_.size()) {
+      handlers_.resize(index + 1);
+    }
+    handlers_[index] = std::move(handler);
+  }
+
+  template <typename Payload, typename Handler>
+  void onPayload(T msg_id, Handler handler) {
+    // the handler is called with (Context..., const Payload &)
+    static_assert(std::is_trivially_copyable<Payload>::value,
+                  "The payload can not be decoded by copying its bytes!");
+    on(msg_id, [this, handler = std::move(handler)](Context... context,
+                                                    message<T> &msg) {
+      if (msg.payload.size() != sizeof(Payload)) {
+        num_malformed_++;
+        return;
+      }
+      Payload payload;
+      memcpy(&payload, msg.payload.data(), sizeof(Payload));
+      handler(context..., payload);
+    });
+  }
+
+  void onUnhandled(handler_type handler) {
+    // called for the ids without a handler
+    unhandled_ = std::move(handler);
+  }
+
+  bool dispatch(Context... context, message<T> &msg) const {
+    // returns false if neither a handler of the id nor an unhandled handler
+    // is registered
+    size_t index = size_t(msg.header.id);
+    if (index < handlers_.size() && handlers_[index]) {
+      handlers_[index](context..., msg);
+      return true;
+    }
+    if (unhandled_) {
+      unhandled_(context..., msg);
+      return true;
+    }
+    return false;
+  }
+
+  uint64_t numMalformed() const { return num_malformed_.load(); }
+
+private:
+  std::vector<handler_type> handlers_; // message id -> handler
+  handler_type unhandled_;
+  std::atomic<uint64_t> num_malformed_{0};
+};
+
+} // namespace custom_netlib
+
+#endif /* MESSAGEDISPATCHERNET */
@@ -0,0 +1,195 @@
+#ifndef MPSCQUEUENET
+#define MPSCQUEUENET
+
+#include "common_net_includes.hpp"
+
+#include <optional>
+
+namespace custom_netlib {
+
+/*
+ * Lock-free multi-producer/single-consumer queue (intrusive linked list after
+ * Dmitry Vyukov). It is a drop-in replacement for the TsNetQueue as incoming
+ * message queue of the server: The I/O threads of the connections push
+ * messages concurrently without taking a lock, and exactly ONE thread (the one
+ * that calls update() on the server) consumes them.
+ *
+ * Only pushBack()/emplaceBack() may be called from multiple threads at the
+ * same time. popFront(), drain(), wait() and clear() must only be called by
+ * the consumer thread.
+ *
+ * Every element lives in its own node, so a push costs one allocation, but no
+ * producer ever blocks another producer or the consumer.
+ */
+template <typename T> class LockFreeMpscQueue {
+public:
+  // rule of five parts
+  LockFreeMpscQueue() : head_(new Node()), tail_(head_.load()) {}
+  LockFreeMpscQueue(const LockFreeMpscQueue<T> &) = delete;
+  virtual ~LockFreeMpscQueue() {
+    this->clear();
+    delete tail_;
+  }
+
+  // methods for the producers
+  void pushBack(const T &input_element) { pushNode(new Node(input_element)); }
+
+  void pushBack(T &&input_element) {
+    pushNode(new Node(std::move(input_element)));
+  }
+
+  template <typename... Args> void emplaceBack(Args &&...args) {
+    pushNode(new Node(std::forward<Args>(args)...));
+  }
+
+  // methods for the consumer
+  bool isEmpty() const { return count_.load() == 0; }
+
+  size_t count() const {
+    /*
+     * Returns the current number of elements within the queue (this is only a
+     * snapshot, since the producers continue to push)
+     */
+    return count_.load();
+  }
+
+  std::optional<T> tryPopFront() {
+    // Returns the front element or nothing, if the queue is empty (or the
+    // producer of the front element has not finished linking it in yet)
+    Node *next = tail_->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return std::nullopt;
+    }
+    std::optional<T> tmp_element = std::move(next->value);
+    next->value.reset(); // next becomes the new (empty) stub node
+    delete tail_;
+    tail_ = next;
+    count_.fetch_sub(1);
+    return tmp_element;
+  }
+
+  T popFront() {
+    // CAUTION: like for the TsNetQueue, the queue needs to be non empty
+    std::optional<T> tmp_element = tryPopFront();
+    while (!tmp_element) {
+      // a producer has announced the element but not linked it in yet
+      std::this_thread::yield();
+      tmp_element = tryPopFront();
+    }
+    return std::move(*tmp_element);
+  }
+
+  template <typename Container>
+  size_t drain(Container &out_container, size_t max_elements = -1) {
+    /*
+     * Moves up to max_elements elements at once to the end of the given
+     * container and returns the number of moved elements
+     */
+    size_t num_drained = 0;
+    while (num_drained < max_elements) {
+      std::optional<T> tmp_element = tryPopFront();
+      if (!tmp_element) {
+        break;
+      }
+      out_container.push_back(std::move(*tmp_element));
+      num_drained++;
+    }
+    return num_drained;
+  }
+
+  template <typename Container> size_t popAll(Container &out_container) {
+    // same batch interface as the TsNetQueue
+    return drain(out_container);
+  }
+
+  template <typename Container>
+  size_t popUpTo(size_t max_elements, Container &out_container) {
+    return drain(out_container, max_elements);
+  }
+
+  void clear() {
+    while (tryPopFront()) {
+    }
+  }
+
+  void wait() {
+    // suspend the consumer until there are messages within the queue
+    while (isEmpty()) {
+      std::unique_lock<std::mutex> lck(mtx_caller_block);
+      consumer_waiting_.store(true);
+      if (!isEmpty()) {
+        // a producer has pushed between the check and the announcement
+        consumer_waiting_.store(false);
+        break;
+      }
+      caller_block.wait(lck);
+      consumer_waiting_.store(false);
+    }
+  }
+
+  template <typename Rep, typename Period>
+  bool waitFor(const std::chrono::duration<Rep, Period> &timeout) {
+    // like wait(), but gives up after the given timeout. Returns true if there
+    // are elements within the queue
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (isEmpty()) {
+      std::unique_lock<std::mutex> lck(mtx_caller_block);
+      consumer_waiting_.store(true);
+      if (!isEmpty()) {
+        consumer_waiting_.store(false);
+        break;
+      }
+      bool timed_out =
+          caller_block.wait_until(lck, deadline) == std::cv_status::timeout;
+      consumer_waiting_.store(false);
+      if (timed_out) {
+        return !isEmpty();
+      }
+    }
+    return true;
+  }
+
+protected:
+  struct Node {
+    Node() = default;
+    template <typename... Args>
+    explicit Node(Args &&...args)
+        : value(std::in_place, std::forward<Args>(args)...) {}
+
+    std::atomic<Node *> next{nullptr};
+    std::optional<T> value;
+  };
+
+  void pushNode(Node *node) {
+    // announce the element before it is linked in, so count_ never drops below
+    // the number of linked elements. count_ and consumer_waiting_ are
+    // sequentially consistent: either the consumer sees the new element before
+    // it goes to sleep or the producer sees the sleeping consumer and wakes it
+    count_.fetch_add(1);
+
+    // link the node in as new head: the exchange orders the producers, after
+    // that the previous head gets a pointer to the new node
+    Node *prev_head = head_.exchange(node, std::memory_order_acq_rel);
+    prev_head->next.store(node, std::memory_order_release);
+
+    if (consumer_waiting_.load()) {
+      std::unique_lock<std::mutex> lck_cond(mtx_caller_block);
+      caller_block.notify_one();
+    }
+  }
+
+  std::atomic<Node *> head_; // last pushed node (producer side)
+  Node *tail_;               // stub node in front of the oldest element
+                             // (consumer side)
+  std::atomic<size_t> count_{0};
+
+  // blocking of the consumer within wait(), only touched by the producers if
+  // the consumer announced that it is going to sleep
+  std::atomic<bool> consumer_waiting_{false};
+  std::condition_variable caller_block;
+  std::mutex mtx_caller_block;
+};
+
+} // namespace custom_netlib
+
+#endif /* MPSCQUEUENET */
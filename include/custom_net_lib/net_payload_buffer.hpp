@@ -0,0 +1,112 @@
+#ifndef PAYLOADBUFFERNET
+#define PAYLOADBUFFERNET
+
+#include "common_net_includes.hpp"
+
+namespace custom_netlib {
+
+/*
+ * Byte container for the payload of a message with small buffer optimization:
+ * Payloads up to InlineCapacity bytes are stored within the object itself, so
+ * pings and other small control messages never allocate memory on the heap.
+ * Larger payloads move to a heap block that grows geometrically (like
+ * std::vector).
+ *
+ * In opposite to std::vector, resize() does NOT initialize new bytes, since
+ * they are always overwritten right after the resize (by the serialization of
+ * the message or by the data that is received from the socket).
+ */
+template <std::size_t InlineCapacity> class PayloadBuffer {
+public:
+  // parts of the rule of five
+  PayloadBuffer() = default;
+
+  PayloadBuffer(const PayloadBuffer &other) { assign(other); }
+
+  PayloadBuffer(PayloadBuffer &&other) noexcept { steal(other); }
+
+  PayloadBuffer &operator=(const PayloadBuffer &other) {
+    if (this != &other) {
+      size_ = 0;
+      assign(other);
+    }
+    return *this;
+  }
+
+  PayloadBuffer &operator=(PayloadBuffer &&other) noexcept {
+    if (this != &other) {
+      heap_.reset();
+      capacity_ = InlineCapacity;
+      steal(other);
+    }
+    return *this;
+  }
+
+  ~PayloadBuffer() = default;
+
+  // methods
+  uint8_t *data() { return heap_ ? heap_.get() : inline_; }
+  const uint8_t *data() const { return heap_ ? heap_.get() : inline_; }
+
+  uint8_t *begin() { return data(); }
+  uint8_t *end() { return data() + size_; }
+  const uint8_t *begin() const { return data(); }
+  const uint8_t *end() const { return data() + size_; }
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  std::size_t capacity() const { return capacity_; }
+
+  bool isInline() const {
+    // true as long as the payload did not need any heap memory
+    return !heap_;
+  }
+
+  void reserve(std::size_t new_capacity) {
+    if (new_capacity <= capacity_) {
+      return;
+    }
+    std::unique_ptr<uint8_t[]> new_heap(new uint8_t[new_capacity]);
+    memcpy(new_heap.get(), data(), size_);
+    heap_ = std::move(new_heap);
+    capacity_ = new_capacity;
+  }
+
+  void resize(std::size_t new_size) {
+    if (new_size > capacity_) {
+      reserve(std::max(new_size, 2 * capacity_));
+    }
+    size_ = new_size;
+  }
+
+  void clear() { size_ = 0; }
+
+private:
+  void assign(const PayloadBuffer &other) {
+    resize(other.size_);
+    memcpy(data(), other.data(), other.size_);
+  }
+
+  void steal(PayloadBuffer &other) {
+    if (other.heap_) {
+      heap_ = std::move(other.heap_);
+      capacity_ = other.capacity_;
+    } else {
+      memcpy(inline_, other.inline_, other.size_);
+    }
+    size_ = other.size_;
+
+    // the moved-from buffer is an empty inline buffer again
+    other.capacity_ = InlineCapacity;
+    other.size_ = 0;
+  }
+
+  std::unique_ptr<uint8_t[]> heap_;
+  std::size_t size_ = 0;
+  std::size_t capacity_ = InlineCapacity;
+  uint8_t inline_[InlineCapacity];
+};
+
+} // namespace custom_netlib
+
+#endif /* PAYLOADBUFFERNET */
@@ -3,40 +3,107 @@
 
 #include "common_net_includes.hpp"
 #include "connection_net_interface.hpp"
+#include "net_backpressure_gate.hpp"
+#include "net_connection_registry.hpp"
+#include "net_config.hpp"
+#include "net_io_context_pool.hpp"
 #include "net_message.hpp"
+#include "net_message_dispatcher.hpp"
+#include "net_mpsc_queue.hpp"
+#include "net_subscription_registry.hpp"
+#include "net_timer_wheel.hpp"
 #include "net_ts_queue.hpp"
+#include "net_worker_pool.hpp"
 
 namespace custom_netlib {
 
-template <typename T> // The template Type defines the message type
+template <typename T, // The template Type defines the message type
+          template <typename> class InQueue =
+              TsNetQueue> // The queue implementation of the incoming message
+                          // queue: TsNetQueue (mutex protected deque) or
+                          // LockFreeMpscQueue (lock-free, the I/O threads push
+                          // and only the thread that calls update() consumes)
 class ServerInterfaceClass {
 public:
   // components of the rule of five
-  ServerInterfaceClass(uint16_t port)
-      : connection_acceptor_server_(
-            ioserv_,
-            boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)) {
-    /* Initializing the listening socket before anything else happens with the
-     * server by creating it with an initializer list This is where the implicit
-     * socket for the listening to new connections is created as the acceptor
-     * object of boost::asio
+  ServerInterfaceClass(uint16_t port,
+                       const ServerConfig &server_config = ServerConfig())
+      : io_pool_(server_config.num_io_threads),
+        connection_config_(server_config.connection),
+        heartbeat_interval_(server_config.heartbeat_interval),
+        idle_timeout_(server_config.idle_timeout),
+        message_handlers_(server_config.num_message_ids),
+        max_incoming_per_client_(
+            server_config.max_incoming_messages_per_client) {
+    /* Initializing the listening sockets before anything else happens with the
+     * server. This is where the implicit socket for the listening to new
+     * connections is created as the acceptor object of boost::asio. Every I/O
+     * service object of the pool is one shard of the server with its own set
+     * of connections
      */
+    boost::asio::ip::tcp::endpoint endpt(boost::asio::ip::tcp::v4(), port);
+    bool reuse_port = server_config.reuse_port_acceptors && kReusePortAvailable;
+    for (size_t n = 0; n < io_pool_.size(); n++) {
+      shards_.emplace_back(std::make_unique<ServerShard>(
+          io_pool_.at(n), server_config.timer_wheel_tick,
+          server_config.timer_wheel_slots));
+      if (n == 0 || reuse_port) {
+        shards_.back()->acceptor =
+            makeAcceptor(io_pool_.at(n), endpt, reuse_port);
+        endpt.port(getPort()); // the other acceptors share the port that the
+                               // OS picked for port 0
+      }
+    }
+    accept_round_robin_ = !reuse_port;
+
+    if (server_config.max_incoming_messages > 0) {
+      incoming_gate_ = std::make_shared<BackpressureGate>(
+          server_config.max_incoming_messages);
+    }
+
+    if (server_config.num_message_workers > 0) {
+      message_workers_ = std::make_unique<WorkerPool<OwnedMessage<T>>>(
+          server_config.num_message_workers, [this](OwnedMessage<T> &msg) {
+            handleMessage(msg);
+          });
+    }
   }
 
+  ServerInterfaceClass(uint16_t port, const ConnectionConfig &connection_config)
+      : ServerInterfaceClass(port, [&connection_config]() {
+          ServerConfig server_config; // one I/O thread
+          server_config.connection = connection_config;
+          return server_config;
+        }()) {}
+
   virtual ~ServerInterfaceClass() { Stop(); }
 
   // methods
   bool Start() {
     try {
-      waitForClientConnection(); // create the "work" for the asio I/O service
-                                 // object such that it does not end before any
-                                 // work comes in
-      thr_io_serv_ = std::thread([this]() {
-        ioserv_.run(); // start the I/O service object and let it listen to new
-                       // connections, since the waitForClientConnection()
-                       // method creates a I/O object/service that calls a
-                       // handler as soon as a new connection request comes in
-      });
+      if (message_workers_) {
+        message_workers_->start(); // the workers need to run before the first
+                                   // message arrives
+      }
+      if (livenessCheckEnabled()) {
+        for (auto &shard : shards_) {
+          TimerWheel *timer_wheel = &shard->timer_wheel;
+          boost::asio::post(shard->ioserv,
+                            [timer_wheel]() { timer_wheel->start(); });
+        }
+      }
+      for (size_t n = 0; n < shards_.size(); n++) {
+        if (shards_[n]->acceptor) {
+          waitForClientConnection(n); // create the "work" for the asio I/O
+                                      // service object such that it does not
+                                      // end before any work comes in
+        }
+      }
+      io_pool_.run(); // start the I/O service objects (one thread each) and
+                      // let the first one listen to new connections, since the
+                      // waitForClientConnection() method creates a I/O
+                      // object/service that calls a handler as soon as a new
+                      // connection request comes in
 
     } catch (std::exception &ec) {
       std::cerr << "[SERVER] ERROR: " << ec.what() << "\n";
@@ -48,31 +115,49 @@ public:
   }
 
   bool Stop() {
-    ioserv_.stop();
-
-    if (thr_io_serv_.joinable()) {
-      thr_io_serv_.join(); // wait/block the execution until the I/O service
-                           // object has successfully stopped
+    io_pool_.stop(); // stops all I/O service objects and joins their threads
+    if (message_workers_) {
+      message_workers_->stop();
     }
 
     std::cout << "[SERVER]: Server stopped.\n";
     return true;
   }
 
+  uint16_t getPort() const {
+    // the port the server listens on (e.g. the one the OS picked for port 0)
+    return shards_.front()->acceptor->local_endpoint().port();
+  }
+
   // asynchronous methods
-  void waitForClientConnection() {
-    connection_acceptor_server_.async_accept([this](
-                                                 boost::system::error_code ec,
-                                                 boost::asio::ip::tcp::socket
-                                                     sock) {
+  void waitForClientConnection(size_t acceptor_shard = 0) {
+    // With one acceptor, the new connection is accepted directly onto the next
+    // I/O service object of the pool (round robin). With SO_REUSEPORT
+    // acceptors, every acceptor keeps its connections on its own I/O service
+    // object. Either way, all handlers of the connection run there
+    size_t connection_shard =
+        accept_round_robin_ ? io_pool_.queryIndex() : acceptor_shard;
+    ServerShard &shard = *shards_[connection_shard];
+    shards_[acceptor_shard]->acceptor->async_accept(
+        shard.ioserv, [this, acceptor_shard, connection_shard,
+                       &shard](boost::system::error_code ec,
+                               boost::asio::ip::tcp::socket sock) {
       if (!ec) {
         std::cout << "[SERVER]: A new connection was established: "
                   << sock.remote_endpoint() << "\n";
 
         std::shared_ptr<ConnectionInterface<T>> new_connection =
             std::make_shared<ConnectionInterface<T>>(
-                ConnectionInterface<T>::Owner::server, ioserv_, std::move(sock),
-                inMsgQueue_);
+                ConnectionInterface<T>::Owner::server, shard.ioserv,
+                std::move(sock), makeIncomingSink(), connection_config_);
+        std::weak_ptr<ConnectionInterface<T>> weak_connection = new_connection;
+        new_connection->SetOutQueueFullHandler([this, weak_connection]() {
+          if (auto client = weak_connection.lock()) {
+            onClientOutQueueFull(client);
+          }
+        });
+        new_connection->SetIncomingLimits(max_incoming_per_client_,
+                                          incoming_gate_);
 
         if (onClientConnect(new_connection)) {
           // Deny the connection if the onClientConnect method delivers false
@@ -82,18 +167,31 @@ public:
           // principals)
           std::cout
               << "[SERVER]: Connection is valid - connection is active now!\n";
-          connectionsQueue_.emplace_back(std::move(
-              new_connection)); // add
-                                // the connection object to the connections
-                                // queue so there will be a shared_ptr after the
-                                // execution of the lambda function and so, the
-                                // connection object will not get deleted if the
-                                // lambda function goes out of scope
-
-          // assigning the identifyer
-          connectionsQueue_.back()->ConnectToClient(this, idCounter_++);
-          std::cout << "[CLIENT " << connectionsQueue_.back()->getID()
-                    << "] connection approved\n";
+
+          // assigning the identifyer and starting the handshake needs to
+          // happen on the I/O service object of the connection, since the
+          // handlers of a connection must never run concurrently (dispatch
+          // runs it right away if we are already there)
+          uint32_t new_id = nextClientID(connection_shard);
+          boost::asio::dispatch(shard.ioserv, [this, new_connection, new_id,
+                                               &shard]() {
+            new_connection->ConnectToClient(this, new_id);
+            {
+              std::unique_lock<std::mutex> lck(shard.connections_mtx);
+              shard.connections.insert(
+                  new_id, new_connection); // add the connection object to the
+                                   // connections queue so there will be a
+                                   // shared_ptr after the execution of the
+                                   // lambda function and so, the connection
+                                   // object will not get deleted if the lambda
+                                   // function goes out of scope
+            }
+            if (livenessCheckEnabled()) {
+              scheduleLivenessCheck(shard, new_connection,
+                                    nextLivenessCheck(new_connection));
+            }
+            std::cout << "[CLIENT " << new_id << "] connection approved\n";
+          });
 
         } else {
           std::cout << "[SERVER]: The server denied the connection!\n";
@@ -104,9 +202,10 @@ public:
         std::cerr << "[SERVER]: ERROR with establishing a new connection: "
                   << ec.message() << "\n";
       }
-      waitForClientConnection(); // calling the wait for new connection method
-                                 // again --> A new asynchronous task will be
-                                 // registered by the I/O service object
+      waitForClientConnection(
+          acceptor_shard); // calling the wait for new connection method
+                           // again --> A new asynchronous task will be
+                           // registered by the I/O service object
     });
     // Explaination: Every time when the asynchronous, out of process event is
     // finished/executed, the given handler will be executed JUST ONE SINGLE
@@ -115,65 +214,170 @@ public:
     // (https://www.boost.org/doc/libs/1_66_0/doc/html/boost_asio/reference/AcceptHandler.html)
   }
 
+  bool sendMessageToClient(uint32_t client_id, const message<T> &msg_to_send,
+                           MessagePriority priority = MessagePriority::Normal) {
+    return sendMessageToClient(client_id, makeSharedMessage(msg_to_send),
+                               priority);
+  }
+
+  bool sendMessageToClient(uint32_t client_id, message<T> &&msg_to_send,
+                           MessagePriority priority = MessagePriority::Normal) {
+    return sendMessageToClient(
+        client_id, makeSharedMessage(std::move(msg_to_send)), priority);
+  }
+
+  bool sendMessageToClient(uint32_t client_id, SharedMessage<T> msg_to_send,
+                           MessagePriority priority = MessagePriority::Normal) {
+    // Send a message to the client with the given identifyer (O(1) lookup
+    // within the shard of the client). Returns false if there is no such
+    // client (anymore)
+    std::shared_ptr<ConnectionInterface<T>> client_connection =
+        findClient(client_id);
+    if (!client_connection) {
+      return false;
+    }
+    sendMessageToClient(std::move(client_connection), std::move(msg_to_send),
+                        priority);
+    return true;
+  }
+
+  std::shared_ptr<ConnectionInterface<T>> findClient(uint32_t client_id) {
+    // the identifyer of a client tells the shard that holds its connection
+    ServerShard &shard = *shards_[client_id % shards_.size()];
+    std::unique_lock<std::mutex> lck(shard.connections_mtx);
+    return shard.connections.find(client_id);
+  }
+
+  void
+  sendMessageToClient(std::shared_ptr<ConnectionInterface<T>> client_connection,
+                      const message<T> &msg_to_send,
+                      MessagePriority priority = MessagePriority::Normal) {
+    sendMessageToClient(std::move(client_connection),
+                        makeSharedMessage(msg_to_send), priority);
+  }
+
+  void
+  sendMessageToClient(std::shared_ptr<ConnectionInterface<T>> client_connection,
+                      message<T> &&msg_to_send,
+                      MessagePriority priority = MessagePriority::Normal) {
+    sendMessageToClient(std::move(client_connection),
+                        makeSharedMessage(std::move(msg_to_send)), priority);
+  }
+
   void
   sendMessageToClient(std::shared_ptr<ConnectionInterface<T>> client_connection,
-                      const message<T> &msg_to_send) {
+                      SharedMessage<T> msg_to_send,
+                      MessagePriority priority = MessagePriority::Normal) {
     if (client_connection && client_connection->IsConnected()) {
       // check if the client object is valid and if the connection to the data
       // exchange socket is existand. If that is given, we can send the message
       // throu the socket
-      client_connection->SendData(msg_to_send);
-    } else {
+      client_connection->SendData(std::move(msg_to_send), priority);
+    } else if (client_connection && removeClient(client_connection->getID())) {
       // we have identified, that the client is not existant in out network
-      // anymore
+      // anymore (and deleted it from the connections of its shard)
       onClientDisconnect(
           client_connection); // since we could not connect to the client, we
                               // want to do something with that information
                               // (e.g. inform other clients that the client is
                               // not accessable anymore)
-      client_connection.reset();
-
-      // delelte the client from the connections queue
-      connectionsQueue_.erase(std::remove(connectionsQueue_.begin(),
-                                          connectionsQueue_.end(),
-                                          client_connection),
-                              connectionsQueue_.end());
     }
   }
 
   void sendMessageToAllClients(
       const message<T> &msg_to_send,
       std::shared_ptr<ConnectionInterface<T>> ignore_client) {
+    // serialize the message ONCE, all connections write from the same memory
+    sendMessageToAllClients(makeSharedMessage(msg_to_send),
+                            std::move(ignore_client));
+  }
+
+  void sendMessageToAllClients(
+      SharedMessage<T> msg_to_send,
+      std::shared_ptr<ConnectionInterface<T>> ignore_client) {
     // send a message to all connected clients except of one client (i.e. if one
     // client does something, that should be messaged to all other client except
     // for itself)
+    //
+    // The caller only posts one task per I/O service object, each task hands
+    // the shared message to the connections of its shard from within their
+    // own I/O thread. So the call costs O(number of I/O threads) instead of
+    // O(number of clients) and the shards fan out in parallel
+    for (auto &shard : shards_) {
+      ServerShard *target_shard = shard.get();
+      boost::asio::post(target_shard->ioserv, [this, target_shard, msg_to_send,
+                                               ignore_client]() {
+        fanOutToShard(*target_shard, msg_to_send, ignore_client);
+      });
+    }
+  }
+
+  // publish/subscribe groups
+  bool subscribe(uint32_t group, uint32_t client_id) {
+    // Adds the client to the group, returns false if there is no such client
+    // or if it is already a member of the group
+    ServerShard &shard = *shards_[client_id % shards_.size()];
+    std::unique_lock<std::mutex> lck(shard.connections_mtx);
+    std::shared_ptr<ConnectionInterface<T>> client_connection =
+        shard.connections.find(client_id);
+    if (!client_connection) {
+      return false;
+    }
+    return shard.subscriptions.subscribe(group, client_id,
+                                         std::move(client_connection));
+  }
 
-    bool invalidClientExistFlag = false;
+  bool unsubscribe(uint32_t group, uint32_t client_id) {
+    ServerShard &shard = *shards_[client_id % shards_.size()];
+    std::unique_lock<std::mutex> lck(shard.connections_mtx);
+    return shard.subscriptions.unsubscribe(group, client_id);
+  }
 
-    for (auto &connIt : connectionsQueue_) {
-      if (connIt && (connIt->IsConnected())) {
-        if (connIt != ignore_client) {
-          connIt->SendData(msg_to_send);
-        }
-      } else {
-        onClientDisconnect(
-            connIt); // since we could not connect to the client, we want to do
-                     // something with that information (e.g. inform other
-                     // clients that the client is not accessable anymore)
-        connIt.reset();
-        invalidClientExistFlag = true;
-      }
+  void publish(uint32_t group, const message<T> &msg_to_send) {
+    publish(group, makeSharedMessage(msg_to_send));
+  }
+
+  void publish(uint32_t group, message<T> &&msg_to_send) {
+    publish(group, makeSharedMessage(std::move(msg_to_send)));
+  }
+
+  void publish(uint32_t group, SharedMessage<T> msg_to_send) {
+    // Send the message to all subscribers of the group. Like a broadcast, the
+    // caller only posts one task per I/O service object and every task only
+    // visits the subscribers within its shard
+    for (auto &shard : shards_) {
+      ServerShard *target_shard = shard.get();
+      boost::asio::post(target_shard->ioserv,
+                        [this, target_shard, group, msg_to_send]() {
+                          fanOutToGroup(*target_shard, group, msg_to_send);
+                        });
     }
+  }
 
-    if (invalidClientExistFlag) {
-      // delete the connections that were not accessable for the message
-      // sending. We do not want to delete an iterator while looping throu the
-      // queue, since this would invalidate the iterator during runtime - this
-      // results in undefined behaviour
-      connectionsQueue_.erase(std::remove(connectionsQueue_.begin(),
-                                          connectionsQueue_.end(), nullptr),
-                              connectionsQueue_.end());
+  using MessageHandlers =
+      MessageDispatcher<T, const std::shared_ptr<ConnectionInterface<T>> &>;
+
+  MessageHandlers &messageHandlers() {
+    // Handlers per message id, called with (client, message) or with
+    // (client, decoded payload) instead of onMessage. CAUTION: register them
+    // before Start(), or (without workers and inline dispatch) from within the
+    // thread that calls update()
+    return message_handlers_;
+  }
+
+  void setInlineDispatch(T msg_id, bool enabled = true) {
+    // Messages with the given id skip the incoming queue (and the workers):
+    // onMessage is called directly within the I/O thread of the connection
+    // that received them. This saves the queue hop and the wake-up of the
+    // consumer for latency critical messages (e.g. pings), but the handler
+    // must be fast and thread safe, since it runs concurrently with update()
+    // (or the workers) and with the other I/O threads.
+    // CAUTION: must be called before Start()
+    size_t index = size_t(msg_id);
+    if (index >= inline_dispatch_.size()) {
+      inline_dispatch_.resize(index + 1, false);
     }
+    inline_dispatch_[index] = enabled;
   }
 
   void update(size_t numMaxMessages = -1, bool enable_waiting = false) {
@@ -193,14 +397,47 @@ public:
       inMsgQueue_.wait();
     }
 
+    // take the messages out of the incoming queue in batches (one lock
+    // acquisition per batch instead of two per message) and process them
     size_t msg_count = 0;
-    while (msg_count < numMaxMessages && !inMsgQueue_.isEmpty()) {
-      auto msg = inMsgQueue_.popFront(); // extract the first element of the
-                                         // incoming (thread save) message queue
-      onMessage(msg.remote, msg.msg);
-      msg_count++;
+    while (msg_count < numMaxMessages) {
+      size_t num_popped =
+          inMsgQueue_.popUpTo(numMaxMessages - msg_count, update_batch_);
+      if (num_popped == 0) {
+        break;
+      }
+
+      for (auto &msg : update_batch_) {
+        handleMessage(msg);
+      }
+      update_batch_.clear();
+      msg_count += num_popped;
     }
   }
+  struct IncomingStats {
+    size_t pending_msgs = 0;       // received, but not processed yet
+    uint64_t num_pauses = 0;       // pauses because of the global mark
+    size_t num_paused_clients = 0; // clients that wait for the global mark
+  };
+
+  IncomingStats getIncomingStats() {
+    // state of the global incoming high-water mark (all zero without it), the
+    // pauses of single clients are reported by their getBackpressureStats()
+    IncomingStats stats;
+    if (incoming_gate_) {
+      stats.pending_msgs = incoming_gate_->pending();
+      stats.num_pauses = incoming_gate_->numPauses();
+      stats.num_paused_clients = incoming_gate_->numWaiting();
+    }
+    return stats;
+  }
+
+  std::vector<size_t> messageWorkerQueueDepths() {
+    // number of messages that wait for each worker (empty without workers)
+    return message_workers_ ? message_workers_->queueDepths()
+                            : std::vector<size_t>();
+  }
+
   virtual void
   onClientValidated(std::shared_ptr<ConnectionInterface<T>> client) {
     std::cout << "OnClientValidated!\n";
@@ -241,6 +478,20 @@ protected:
      */
   }
 
+  virtual void
+  onClientOutQueueFull(std::shared_ptr<ConnectionInterface<T>> /*client*/) {
+    /*
+     * Gets called (from the I/O thread of the client) if the outgoing message
+     * queue of the client reaches its high-water mark, i.e. the client does
+     * not read fast enough. The out queue policy of the connection config
+     * decides what happens with the messages. The call happens after the
+     * send, broadcast or publish that hit the mark has finished, so the
+     * method may (un)subscribe the client or send messages itself.
+     *
+     * Example: Log the slow client or send it less updates
+     */
+  }
+
   virtual void onMessage(std::shared_ptr<ConnectionInterface<T>> client,
                          message<T> &msg_input) {
     /*
@@ -249,22 +500,272 @@ protected:
      *
      * This method defines, how to deal with the message if it is already
      * arrived and deserialized
+     *
+     * Only called for the messages without a handler within
+     * messageHandlers()
      */
   }
 
+  struct ServerShard {
+    // One I/O service object of the pool together with the connections that
+    // are bound to it and (optionally) its own acceptor
+    ServerShard(boost::asio::io_context &ioserv_,
+                std::chrono::milliseconds timer_wheel_tick,
+                size_t timer_wheel_slots)
+        : ioserv(ioserv_),
+          timer_wheel(ioserv_, timer_wheel_tick, timer_wheel_slots) {}
+
+    boost::asio::io_context &ioserv;
+    TimerWheel timer_wheel; // heartbeats and idle timeouts of the connections
+    std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor;
+    ConnectionRegistry<T> connections;
+    SubscriptionRegistry<T> subscriptions; // groups of the connections
+    std::mutex connections_mtx; // protects connections and subscriptions,
+                                // since they are changed by several threads
+    std::atomic<uint32_t>
+        id_counter{0}; // working with identify counters is much easyer then
+                       // working with socket-addresses and even more secure
+                       // (since we do not need to send socket information
+                       // over the network)
+  };
+
+#ifdef SO_REUSEPORT
+  using reuse_port_option =
+      boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+  static constexpr bool kReusePortAvailable = true;
+#else
+  static constexpr bool kReusePortAvailable = false;
+#endif
+
+  void
+  fanOutToShard(ServerShard &shard, const SharedMessage<T> &msg_to_send,
+                const std::shared_ptr<ConnectionInterface<T>> &ignore_client) {
+    // runs within the I/O service object of the shard, so the message can be
+    // queued directly at the connections (no task per connection)
+    std::vector<std::shared_ptr<ConnectionInterface<T>>> invalid_clients;
+    {
+      std::unique_lock<std::mutex> lck(shard.connections_mtx);
+      for (const auto &connIt : shard.connections) {
+        if (connIt->IsConnected()) {
+          if (connIt != ignore_client) {
+            connIt->QueueMessage(msg_to_send);
+          }
+        } else {
+          invalid_clients.emplace_back(connIt);
+        }
+      }
+
+      // delete the connections that were not accessable for the message
+      // sending. We do not want to delete an element while looping throu the
+      // registry, since this would invalidate the iterator during runtime -
+      // this results in undefined behaviour
+      for (auto &client : invalid_clients) {
+        eraseClient(shard, client->getID());
+      }
+    }
+
+    for (auto &client : invalid_clients) {
+      onClientDisconnect(
+          client); // since we could not connect to the client, we want to do
+                   // something with that information (e.g. inform other
+                   // clients that the client is not accessable anymore). This
+                   // happens outside of the lock, so the callback may send
+                   // messages itself
+    }
+  }
+
+  bool livenessCheckEnabled() const {
+    return heartbeat_interval_.count() > 0 || idle_timeout_.count() > 0;
+  }
+
+  std::chrono::milliseconds
+  nextLivenessCheck(const std::shared_ptr<ConnectionInterface<T>> &client) {
+    // time until the next heartbeat is due or until the connection expires
+    auto idle_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - client->lastReceiveTime());
+    auto next_check = std::chrono::milliseconds::max();
+    if (heartbeat_interval_.count() > 0) {
+      next_check = (idle_time < heartbeat_interval_)
+                       ? heartbeat_interval_ - idle_time
+                       : heartbeat_interval_; // repeat the heartbeat requests
+    }
+    if (idle_timeout_.count() > 0) {
+      next_check = std::min(next_check, idle_timeout_ - idle_time);
+    }
+    return next_check;
+  }
+
+  void scheduleLivenessCheck(ServerShard &shard,
+                             std::weak_ptr<ConnectionInterface<T>> weak_client,
+                             std::chrono::milliseconds delay) {
+    // the timer wheel only holds a weak reference, so it never keeps a
+    // removed connection alive
+    shard.timer_wheel.schedule(delay, [this, &shard, weak_client]() {
+      checkLiveness(shard, weak_client);
+    });
+  }
+
+  void checkLiveness(ServerShard &shard,
+                     std::weak_ptr<ConnectionInterface<T>> weak_client) {
+    // runs within the I/O service object of the shard (and of the connection)
+    std::shared_ptr<ConnectionInterface<T>> client = weak_client.lock();
+    if (!client) {
+      return;
+    }
+
+    auto idle_time =
+        std::chrono::steady_clock::now() - client->lastReceiveTime();
+    bool expired = !client->IsConnected() ||
+                   (idle_timeout_.count() > 0 && idle_time >= idle_timeout_);
+    if (expired) {
+      if (client->IsConnected()) {
+        std::cout << "[" << client->getID()
+                  << "]: no data received within the idle timeout\n";
+        client->Disconnect();
+      }
+      if (removeClient(client->getID())) {
+        onClientDisconnect(client);
+      }
+      return;
+    }
+
+    if (heartbeat_interval_.count() > 0 && idle_time >= heartbeat_interval_) {
+      client->SendHeartbeat();
+    }
+    scheduleLivenessCheck(shard, client, nextLivenessCheck(client));
+  }
+
+  uint32_t nextClientID(size_t shard_index) {
+    // identifyers are never reused and every identifyer modulo the number of
+    // shards is the index of the shard that holds the connection
+    uint32_t shard_counter = shards_[shard_index]->id_counter++;
+    return shard_counter * uint32_t(shards_.size()) + uint32_t(shard_index);
+  }
+
+  void fanOutToGroup(ServerShard &shard, uint32_t group,
+                     const SharedMessage<T> &msg_to_send) {
+    // runs within the I/O service object of the shard
+    std::vector<std::shared_ptr<ConnectionInterface<T>>> invalid_clients;
+    {
+      std::unique_lock<std::mutex> lck(shard.connections_mtx);
+      const ConnectionRegistry<T> *subscribers =
+          shard.subscriptions.subscribers(group);
+      if (!subscribers) {
+        return; // nobody within this shard subscribed to the group
+      }
+      for (const auto &connIt : *subscribers) {
+        if (connIt->IsConnected()) {
+          connIt->QueueMessage(msg_to_send);
+        } else {
+          invalid_clients.emplace_back(connIt);
+        }
+      }
+      for (auto &client : invalid_clients) {
+        eraseClient(shard, client->getID());
+      }
+    }
+
+    for (auto &client : invalid_clients) {
+      onClientDisconnect(client);
+    }
+  }
+
+  static bool eraseClient(ServerShard &shard, uint32_t client_id) {
+    // CAUTION: the connections mutex of the shard needs to be locked
+    shard.subscriptions.unsubscribeAll(client_id);
+    return shard.connections.erase(client_id);
+  }
+
+  bool removeClient(uint32_t client_id) {
+    ServerShard &shard = *shards_[client_id % shards_.size()];
+    std::unique_lock<std::mutex> lck(shard.connections_mtx);
+    return eraseClient(shard, client_id);
+  }
+
+  typename ConnectionInterface<T>::IncomingSink makeIncomingSink() {
+    // the messages of the connections either go to the incoming queue (that is
+    // processed by update()) or directly to the worker of the client
+    if (message_workers_) {
+      return [this](OwnedMessage<T> &&owned_msg) {
+        if (dispatchInline(owned_msg)) {
+          return;
+        }
+        size_t worker_key = owned_msg.remote->getID();
+        message_workers_->push(worker_key, std::move(owned_msg));
+      };
+    }
+    return [this](OwnedMessage<T> &&owned_msg) {
+      if (dispatchInline(owned_msg)) {
+        return;
+      }
+      inMsgQueue_.pushBack(std::move(owned_msg));
+    };
+  }
+
+  bool dispatchInline(OwnedMessage<T> &owned_msg) {
+    // handles the message within the I/O thread if its id was registered with
+    // setInlineDispatch()
+    size_t index = size_t(owned_msg.msg.header.id);
+    if (index >= inline_dispatch_.size() || !inline_dispatch_[index]) {
+      return false;
+    }
+    handleMessage(owned_msg);
+    return true;
+  }
+
+  void handleMessage(OwnedMessage<T> &owned_msg) {
+    // the handler that is registered for the id, otherwise onMessage
+    if (!message_handlers_.dispatch(owned_msg.remote, owned_msg.msg)) {
+      onMessage(owned_msg.remote, owned_msg.msg);
+    }
+    owned_msg.remote->MessageConsumed();
+  }
+
+  static std::unique_ptr<boost::asio::ip::tcp::acceptor>
+  makeAcceptor(boost::asio::io_context &ioserv,
+               const boost::asio::ip::tcp::endpoint &endpt,
+               [[maybe_unused]] bool reuse_port) {
+    // same as the endpoint constructor of the acceptor, but with SO_REUSEPORT
+    // if requested, so multiple acceptors can listen on the same port. Only
+    // the sharded acceptors set it: a single acceptor must fail if the port
+    // is already taken (by another process)
+    auto acceptor = std::make_unique<boost::asio::ip::tcp::acceptor>(ioserv);
+    acceptor->open(endpt.protocol());
+    acceptor->set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+#ifdef SO_REUSEPORT
+    if (reuse_port) {
+      acceptor->set_option(reuse_port_option(true));
+    }
+#endif
+    acceptor->bind(endpt);
+    acceptor->listen();
+    return acceptor;
+  }
+
   // members
-  TsNetQueue<OwnedMessage<T>> inMsgQueue_;
-  std::deque<std::shared_ptr<ConnectionInterface<T>>> connectionsQueue_;
   // CAUTION: The order of the initialization is given by the order of the
-  // members in the code. The ioserv needs to be initalized BEFORE the thread is
-  // initialized where is should run
-  boost::asio::io_context ioserv_;
-  std::thread thr_io_serv_;
-  boost::asio::ip::tcp::acceptor connection_acceptor_server_;
-  uint32_t
-      idCounter_; // working with identify counters is much easyer then working
-                  // with socket-addresses and even more secure (since we do not
-                  // need to send socket information over the network)
+  // members in the code. The I/O service objects need to be initalized BEFORE
+  // (and destroyed AFTER) the sockets of the acceptors and the connections
+  IoContextPool io_pool_;
+  InQueue<OwnedMessage<T>> inMsgQueue_;
+  std::deque<OwnedMessage<T>>
+      update_batch_; // messages that update() currently processes
+  std::unique_ptr<WorkerPool<OwnedMessage<T>>>
+      message_workers_; // only if the server config requests workers
+  std::vector<std::unique_ptr<ServerShard>>
+      shards_; // one shard per I/O service object of the pool
+  bool accept_round_robin_ = true; // one acceptor hands out the connections to
+                                   // all shards
+  ConnectionConfig connection_config_; // handed to every new connection
+  std::chrono::milliseconds heartbeat_interval_;
+  std::chrono::milliseconds idle_timeout_;
+  MessageHandlers message_handlers_;
+  std::vector<bool>
+      inline_dispatch_; // message id -> onMessage runs within the I/O thread
+  std::shared_ptr<BackpressureGate>
+      incoming_gate_; // messages of all clients that are not processed yet
+                      // (nullptr: unlimited)
+  size_t max_incoming_per_client_;
 };
 
 } // namespace custom_netlib
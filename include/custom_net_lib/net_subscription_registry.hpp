@@ -0,0 +1,90 @@
+#ifndef SUBSCRIPTIONREGISTRYNET
+#define SUBSCRIPTIONREGISTRYNET
+
+#include "common_net_includes.hpp"
+#include "net_connection_registry.hpp"
+
+#include <unordered_map>
+
+namespace custom_netlib {
+
+/*
+ * Members of the publish/subscribe groups of the server. Every group is a
+ * ConnectionRegistry of its subscribers, so publishing to a group only
+ * touches the connections that subscribed to it (instead of scanning all
+ * connections). A second map remembers the groups of every client, so a
+ * disconnected client can be removed from all of its groups at once.
+ *
+ * Groups are identified by numbers (e.g. an enum of the application or the
+ * hash of a topic name). Empty groups are deleted.
+ *
+ * The registry itself is not thread safe, the owner protects it.
+ */
+template <typename T> class SubscriptionRegistry {
+public:
+  using connection_ptr = typename ConnectionRegistry<T>::connection_ptr;
+
+  bool subscribe(uint32_t group, uint32_t client_id,
+                 connection_ptr connection) {
+    // returns false if the client is already a member of the group
+    if (!groups_[group].insert(client_id, std::move(connection))) {
+      return false;
+    }
+    groups_by_client_[client_id].emplace_back(group);
+    return true;
+  }
+
+  bool unsubscribe(uint32_t group, uint32_t client_id) {
+    auto group_it = groups_.find(group);
+    if (group_it == groups_.end() || !group_it->second.erase(client_id)) {
+      return false;
+    }
+    if (group_it->second.empty()) {
+      groups_.erase(group_it);
+    }
+
+    std::vector<uint32_t> &client_groups = groups_by_client_[client_id];
+    client_groups.erase(
+        std::find(client_groups.begin(), client_groups.end(), group));
+    if (client_groups.empty()) {
+      groups_by_client_.erase(client_id);
+    }
+    return true;
+  }
+
+  size_t unsubscribeAll(uint32_t client_id) {
+    // removes the client from all of its groups and returns their number
+    auto client_it = groups_by_client_.find(client_id);
+    if (client_it == groups_by_client_.end()) {
+      return 0;
+    }
+    std::vector<uint32_t> client_groups = std::move(client_it->second);
+    groups_by_client_.erase(client_it);
+
+    for (uint32_t group : client_groups) {
+      auto group_it = groups_.find(group);
+      group_it->second.erase(client_id);
+      if (group_it->second.empty()) {
+        groups_.erase(group_it);
+      }
+    }
+    return client_groups.size();
+  }
+
+  const ConnectionRegistry<T> *subscribers(uint32_t group) const {
+    // nullptr if nobody subscribed to the group
+    auto group_it = groups_.find(group);
+    return group_it == groups_.end() ? nullptr : &group_it->second;
+  }
+
+  size_t numGroups() const { return groups_.size(); }
+
+private:
+  std::unordered_map<uint32_t, ConnectionRegistry<T>> groups_;
+  std::unordered_map<uint32_t, std::vector<uint32_t>>
+      groups_by_client_; // client ID -> groups of the client
+};
+
+} // namespace custom_netlib
+
+#endif /* SUBSCRIPTIONREGISTRYNET */
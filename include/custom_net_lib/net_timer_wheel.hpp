@@ -0,0 +1,151 @@
+#ifndef TIMERWHEELNET
+#define TIMERWHEELNET
+
+#include "common_net_includes.hpp"
+
+#include <unordered_map>
+
+namespace custom_netlib {
+
+/*
+ * Hashed timing wheel that runs within one I/O service object. Instead of one
+ * steady_timer per connection, ONE steady_timer ticks the wheel and every
+ * tick fires the callbacks within the current slot. A timeout that is longer
+ * than one revolution of the wheel stays within its slot for the needed
+ * number of rounds.
+ *
+ * Scheduling, cancelling and firing is O(1) per timeout, the price is a
+ * resolution of one tick. Callbacks that watch a condition (e.g. the time of
+ * the last activity of a connection) check it when they fire and schedule
+ * themselves again if necessary. Timeouts that become pointless (e.g. of a
+ * request that got its response) are cancelled, which releases their
+ * callback right away.
+ *
+ * CAUTION: All methods must be called from within the I/O service object.
+ */
+class TimerWheel {
+public:
+  using callback_type = std::function<void()>;
+  using timer_id = uint64_t; // 0 is never used
+
+  TimerWheel(boost::asio::io_context &ioserv, std::chrono::milliseconds tick,
+             size_t num_slots)
+      : timer_(ioserv), tick_(std::max(tick, std::chrono::milliseconds(1))),
+        slots_(std::max<size_t>(num_slots, 1)) {}
+
+  TimerWheel(const TimerWheel &) = delete;
+
+  void start() {
+    if (running_) {
+      return;
+    }
+    running_ = true;
+    next_tick_ = std::chrono::steady_clock::now() + tick_;
+    waitForTick();
+  }
+
+  void stop() {
+    running_ = false;
+    timer_.cancel();
+  }
+
+  timer_id schedule(std::chrono::milliseconds delay, callback_type callback) {
+    // the callback fires after the delay (rounded up to full ticks), a delay
+    // that is already over fires with the next tick
+    delay = std::max(delay, std::chrono::milliseconds(0));
+    size_t ticks = std::max<size_t>(
+        (delay + tick_ - std::chrono::milliseconds(1)) / tick_, 1);
+    size_t slot = (current_slot_ + ticks) % slots_.size();
+    timer_id id = next_id_++;
+    positions_[id] = {slot, slots_[slot].size()};
+    slots_[slot].push_back(
+        {id, (ticks - 1) / slots_.size(), std::move(callback)});
+    return id;
+  }
+
+  bool cancel(timer_id id) {
+    // Removes the entry, returns false if it has already fired (or is just
+    // firing within the current tick)
+    auto position = positions_.find(id);
+    if (position == positions_.end()) {
+      return false;
+    }
+    std::vector<Entry> &slot = slots_[position->second.first];
+    size_t index = position->second.second;
+    positions_.erase(position);
+    if (index + 1 != slot.size()) {
+      // the last entry of the slot takes the place of the cancelled one
+      slot[index] = std::move(slot.back());
+      positions_[slot[index].id].second = index;
+    }
+    slot.pop_back();
+    return true;
+  }
+
+  size_t size() const { return positions_.size(); }
+
+  bool running() const { return running_; }
+
+  std::chrono::milliseconds tick() const { return tick_; }
+
+private:
+  struct Entry {
+    timer_id id;
+    size_t rounds; // number of revolutions until the entry expires
+    callback_type callback;
+  };
+
+  void waitForTick() {
+    timer_.expires_at(next_tick_);
+    timer_.async_wait([this](boost::system::error_code ec) {
+      if (ec || !running_) {
+        return; // the wheel was stopped
+      }
+      advance();
+      next_tick_ += tick_; // no drift, even if the handler runs late
+      waitForTick();
+    });
+  }
+
+  void advance() {
+    current_slot_ = (current_slot_ + 1) % slots_.size();
+    std::vector<Entry> &slot = slots_[current_slot_];
+
+    // collect the expired entries first, since their callbacks may schedule
+    // new entries (also into this slot)
+    auto still_waiting =
+        std::partition(slot.begin(), slot.end(),
+                       [](const Entry &entry) { return entry.rounds > 0; });
+    for (auto it = slot.begin(); it != still_waiting; ++it) {
+      it->rounds--;
+    }
+    std::move(still_waiting, slot.end(), std::back_inserter(expired_));
+    slot.erase(still_waiting, slot.end());
+    for (size_t index = 0; index < slot.size(); index++) {
+      positions_[slot[index].id].second = index; // the partition moved them
+    }
+    for (const Entry &entry : expired_) {
+      positions_.erase(entry.id);
+    }
+
+    for (Entry &entry : expired_) {
+      entry.callback();
+    }
+    expired_.clear();
+  }
+
+  boost::asio::steady_timer timer_;
+  std::chrono::milliseconds tick_;
+  std::vector<std::vector<Entry>> slots_;
+  std::vector<Entry> expired_; // reused between the ticks
+  std::unordered_map<timer_id, std::pair<size_t, size_t>>
+      positions_; // id -> slot and index within the slot of every entry
+  timer_id next_id_ = 1;
+  size_t current_slot_ = 0;
+  bool running_ = false;
+  std::chrono::steady_clock::time_point next_tick_;
+};
+
+} // namespace custom_netlib
+
+#endif /* TIMERWHEELNET */
@@ -0,0 +1,66 @@
+#ifndef TOKENBUCKETNET
+#define TOKENBUCKETNET
+
+#include "common_net_includes.hpp"
+
+namespace custom_netlib {
+
+/*
+ * Token bucket for rate limiting: The bucket is refilled with rate_per_second
+ * tokens per second up to its capacity. Every event takes its cost out of the
+ * bucket, even if that makes the bucket negative (so an event that costs more
+ * than the capacity, e.g. one large message, is still possible). As long as
+ * the bucket is empty or negative, the owner has to wait.
+ *
+ * A rate of 0 means unlimited. The bucket is not thread safe.
+ */
+class TokenBucket {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  TokenBucket() = default;
+
+  TokenBucket(double rate_per_second, double capacity)
+      : rate_per_second_(rate_per_second), capacity_(capacity),
+        tokens_(capacity), last_refill_(clock_type::now()) {}
+
+  bool unlimited() const { return rate_per_second_ <= 0; }
+
+  void refill(clock_type::time_point now) {
+    if (unlimited()) {
+      return;
+    }
+    double elapsed_seconds =
+        std::chrono::duration<double>(now - last_refill_).count();
+    tokens_ = std::min(capacity_, tokens_ + elapsed_seconds * rate_per_second_);
+    last_refill_ = now;
+  }
+
+  bool empty() const { return !unlimited() && tokens_ <= 0; }
+
+  void consume(double cost) {
+    if (!unlimited()) {
+      tokens_ -= cost;
+    }
+  }
+
+  std::chrono::nanoseconds timeUntilAvailable() const {
+    // time until the bucket has tokens again (after the last refill)
+    if (!empty()) {
+      return std::chrono::nanoseconds(0);
+    }
+    // at least one nanosecond, since the bucket needs to become positive
+    return std::chrono::nanoseconds(
+        int64_t((-tokens_ / rate_per_second_) * 1e9) + 1);
+  }
+
+private:
+  double rate_per_second_ = 0;
+  double capacity_ = 0;
+  double tokens_ = 0;
+  clock_type::time_point last_refill_;
+};
+
+} // namespace custom_netlib
+
+#endif /* TOKENBUCKETNET */
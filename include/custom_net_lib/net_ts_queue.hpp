@@ -2,7 +2,6 @@
 #define TSQUEUENET
 
 #include "common_net_includes.hpp"
-#include "connection_net_interface.hpp"
 #include "net_message.hpp"
 #include "net_ts_queue.hpp"
 
@@ -36,6 +35,18 @@ public:
 
   // insert at the front and at the back of the queue
   void pushBack(const T &input_element) {
+    /*
+     * Adding a copy of the element to the queue
+     */
+    std::unique_lock<std::mutex> lck(mutex_q_);
+    data_queue_.emplace_back(input_element);
+
+    // signal the condition variable that there is now an element within the
+    // queue
+    elementAdded(lck);
+  }
+
+  void pushBack(T &&input_element) {
     /*
      * Adding elements to the queue by using move semantics, since we want to
      * hand over ownership from one thread to another of the elements
@@ -45,17 +56,38 @@ public:
 
     // signal the condition variable that there is now an element within the
     // queue
-    std::unique_lock<std::mutex> lck_cond(mtx_caller_block);
-    caller_block.notify_one();
+    elementAdded(lck);
+  }
+
+  template <typename... Args> void emplaceBack(Args &&...args) {
+    /*
+     * Constructing the element directly within the queue out of the given
+     * constructor arguments (no temporary element that needs to be moved)
+     */
+    std::unique_lock<std::mutex> lck(mutex_q_);
+    data_queue_.emplace_back(std::forward<Args>(args)...);
+
+    // signal the condition variable that there is now an element within the
+    // queue
+    elementAdded(lck);
   }
+
   void pushFront(const T &input_element) {
+    std::unique_lock<std::mutex> lck(mutex_q_);
+    data_queue_.push_front(input_element);
+
+    // signal the condition variable that there is now an element within the
+    // queue
+    elementAdded(lck);
+  }
+
+  void pushFront(T &&input_element) {
     std::unique_lock<std::mutex> lck(mutex_q_);
     data_queue_.push_front(std::move(input_element));
 
     // signal the condition variable that there is now an element within the
     // queue
-    std::unique_lock<std::mutex> lck_cond(mtx_caller_block);
-    caller_block.notify_one();
+    elementAdded(lck);
   }
 
   bool isEmpty() {
@@ -74,6 +106,7 @@ public:
   void clear() {
     std::unique_lock<std::mutex> lck(mutex_q_);
     data_queue_.clear();
+    num_elements_.store(0);
   }
 
   T popFront() {
@@ -82,6 +115,7 @@ public:
         data_queue_
             .front()); // using move semantics to make the code more efficient
     data_queue_.pop_front();
+    num_elements_.store(data_queue_.size());
     return tmp_element;
   }
 
@@ -89,43 +123,149 @@ public:
     std::unique_lock<std::mutex> lck(mutex_q_);
     auto tmp_element = std::move(data_queue_.back());
     data_queue_.pop_back();
+    num_elements_.store(data_queue_.size());
     return tmp_element;
   }
 
+  size_t popAll(std::deque<T> &out_container) {
+    /*
+     * Takes all elements out of the queue with ONE lock acquisition and
+     * returns their number. If the given container is empty, the internal
+     * deque is just swapped with it (O(1), no element is moved at all)
+     */
+    std::unique_lock<std::mutex> lck(mutex_q_);
+    size_t num_popped = data_queue_.size();
+    if (out_container.empty()) {
+      data_queue_.swap(out_container);
+    } else {
+      std::move(data_queue_.begin(), data_queue_.end(),
+                std::back_inserter(out_container));
+      data_queue_.clear();
+    }
+    num_elements_.store(0);
+    return num_popped;
+  }
+
+  size_t popUpTo(size_t max_elements, std::deque<T> &out_container) {
+    /*
+     * Takes up to max_elements elements from the front of the queue with ONE
+     * lock acquisition, appends them to the given container and returns their
+     * number
+     */
+    std::unique_lock<std::mutex> lck(mutex_q_);
+    if (max_elements >= data_queue_.size() && out_container.empty()) {
+      size_t num_popped = data_queue_.size();
+      data_queue_.swap(out_container);
+      num_elements_.store(0);
+      return num_popped;
+    }
+
+    size_t num_popped = std::min(max_elements, data_queue_.size());
+    std::move(data_queue_.begin(), data_queue_.begin() + num_popped,
+              std::back_inserter(out_container));
+    data_queue_.erase(data_queue_.begin(), data_queue_.begin() + num_popped);
+    num_elements_.store(data_queue_.size());
+    return num_popped;
+  }
+
   void wait() {
-    // suspend the calling object until there are messages within the queue
-    while (isEmpty()) {
-      std::unique_lock<std::mutex> lck(
-          mtx_caller_block); // This is a core guideline in order to avoid
-                             // missing out freeing the condition variable
-                             // before the condition variable was set to wait()
-                             // (ref.:
-                             // https://www.modernescpp.com/index.php/c-core-guidelines-be-aware-of-the-traps-of-condition-variables)
-      caller_block.wait(
-          lck); // blocks the thread, where the .wait() method of the thread
-                // safe queue was called from. It will be reactivated if a
-                // pushBack() or pushFront() is called and notify the condition
-                // variable. Then the while loop will continue if there is no
-                // element in the queue or if there is an element in the queue,
-                // the wait function will end and the server application will
-                // continue
+    /*
+     * suspend the calling object until there are messages within the queue.
+     * First, the caller spins for a short time (a message that arrives within
+     * that time is picked up without any context switch), then it parks on the
+     * condition variable that is tied to the same mutex that protects the data.
+     * Since the emptiness check and the parking happen under this mutex, a
+     * pushBack() can not slip in between them (no lost wakeups)
+     */
+    if (spin(spin_duration_)) {
+      return;
     }
+
+    std::unique_lock<std::mutex> lck(mutex_q_);
+    num_waiting_callers_++;
+    caller_block.wait(lck, [this]() {
+      return !data_queue_.empty();
+    }); // blocks the thread, where the .wait() method of the thread safe queue
+        // was called from. It will be reactivated if an element is added and
+        // the condition variable is notified. The predicate protects against
+        // spurious wakeups (ref.:
+        // https://www.modernescpp.com/index.php/c-core-guidelines-be-aware-of-the-traps-of-condition-variables)
+    num_waiting_callers_--;
+  }
+
+  template <typename Rep, typename Period>
+  bool waitFor(const std::chrono::duration<Rep, Period> &timeout) {
+    /*
+     * Like wait(), but gives up after the given timeout. Returns true if there
+     * are elements within the queue and false if the timeout has expired. The
+     * spinning counts towards the timeout
+     */
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    if (spin(std::min(spin_duration_,
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          timeout)))) {
+      return true;
+    }
+
+    std::unique_lock<std::mutex> lck(mutex_q_);
+    num_waiting_callers_++;
+    bool has_elements = caller_block.wait_until(
+        lck, deadline, [this]() { return !data_queue_.empty(); });
+    num_waiting_callers_--;
+    return has_elements;
+  }
+
+  void setSpinDuration(std::chrono::nanoseconds spin_duration) {
+    // how long wait() and waitFor() spin before they park the calling thread
+    // (zero disables the spinning, e.g. on machines with a single core)
+    spin_duration_ = spin_duration;
   }
 
 protected:
+  void elementAdded(std::unique_lock<std::mutex> &lck) {
+    // called by all methods that add elements while they hold the lock
+    num_elements_.store(data_queue_.size());
+    bool caller_waiting = num_waiting_callers_ > 0;
+    lck.unlock(); // the woken up thread should not block on the mutex again
+
+    // notifying the condition variable costs a system call, so it is only done
+    // if there is actually a thread parked within wait() or waitFor()
+    if (caller_waiting) {
+      caller_block.notify_one();
+    }
+  }
+
+  bool spin(std::chrono::nanoseconds spin_duration) {
+    // busy waiting on the element counter without taking the lock
+    auto spin_end = std::chrono::steady_clock::now() + spin_duration;
+    do {
+      if (num_elements_.load(std::memory_order_acquire) > 0) {
+        return true;
+      }
+    } while (std::chrono::steady_clock::now() < spin_end);
+    return false;
+  }
+
   // protected --> classes that inherit from TsNetQueue can directly access this
   // member functions
   std::mutex mutex_q_;
   std::deque<T> data_queue_;
+  std::atomic<size_t> num_elements_{
+      0}; // mirror of data_queue_.size() that can be read without the lock
 
   std::condition_variable
       caller_block; // condition variables are shared ressources that can block
-                    // a thread until another thread unlocks the condition
-                    // variable --> We need two threads to have access to the
-                    // condition variable in order to use it properly
-  std::mutex mtx_caller_block;
+                    // a thread until another thread notifies the condition
+                    // variable --> it uses mutex_q_, so checking the data and
+                    // going to sleep is one atomic step for the other threads
+  size_t num_waiting_callers_ = 0; // protected by mutex_q_
+  std::chrono::nanoseconds spin_duration_ =
+      std::thread::hardware_concurrency() > 1
+          ? std::chrono::microseconds(50)
+          : std::chrono::microseconds(0); // spinning on a single core only
+                                          // delays the thread that pushes
 };
 
 } // namespace custom_netlib
 
-#endif /* TSQUEUENET */
\ No newline at end of file
+#endif /* TSQUEUENET */
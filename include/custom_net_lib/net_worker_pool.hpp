@@ -0,0 +1,103 @@
+#ifndef WORKERPOOLNET
+#define WORKERPOOLNET
+
+#include "common_net_includes.hpp"
+#include "net_ts_queue.hpp"
+
+namespace custom_netlib {
+
+/*
+ * Pool of worker threads that process tasks in parallel, while all tasks with
+ * the same key are processed in the order of their arrival: Every worker has
+ * its own queue and a task always goes to the worker key % number of workers.
+ *
+ * The server uses the client ID as key, so the messages of one client are
+ * handled one after another by the same worker, while slow handlers of one
+ * client do not block the clients of the other workers.
+ */
+template <typename Task> class WorkerPool {
+public:
+  using handler_type = std::function<void(Task &)>;
+
+  WorkerPool(size_t num_workers, handler_type handler)
+      : handler_(std::move(handler)) {
+    num_workers = std::max<size_t>(num_workers, 1);
+    for (size_t n = 0; n < num_workers; n++) {
+      workers_.emplace_back(std::make_unique<Worker>());
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+
+  ~WorkerPool() { stop(); }
+
+  void start() {
+    // start one thread per worker (does not block the caller)
+    if (running_.exchange(true)) {
+      return;
+    }
+    for (auto &worker : workers_) {
+      Worker *w = worker.get();
+      w->thread = std::thread([this, w]() { processTasks(*w); });
+    }
+  }
+
+  void stop() {
+    // the workers finish the batch that they are currently processing, the
+    // tasks that are left within the queues are dropped
+    running_ = false;
+    for (auto &worker : workers_) {
+      if (worker->thread.joinable()) {
+        worker->thread.join();
+      }
+    }
+  }
+
+  void push(size_t key, Task &&task) {
+    workers_[key % workers_.size()]->queue.pushBack(std::move(task));
+  }
+
+  size_t size() const { return workers_.size(); }
+
+  size_t queueDepth(size_t worker_index) {
+    // number of tasks that wait for the given worker (this is only a snapshot)
+    return workers_[worker_index]->queue.count();
+  }
+
+  std::vector<size_t> queueDepths() {
+    std::vector<size_t> depths;
+    for (size_t n = 0; n < workers_.size(); n++) {
+      depths.emplace_back(queueDepth(n));
+    }
+    return depths;
+  }
+
+private:
+  struct Worker {
+    TsNetQueue<Task> queue;
+    std::deque<Task> batch; // tasks that the worker currently processes
+    std::thread thread;
+  };
+
+  void processTasks(Worker &worker) {
+    while (running_) {
+      // the timeout only bounds the time that stop() waits for an idle worker
+      if (!worker.queue.waitFor(std::chrono::milliseconds(100))) {
+        continue;
+      }
+      worker.queue.popAll(worker.batch);
+      for (auto &task : worker.batch) {
+        handler_(task);
+      }
+      worker.batch.clear();
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  handler_type handler_;
+  std::atomic<bool> running_{false};
+};
+
+} // namespace custom_netlib
+
+#endif /* WORKERPOOLNET */
@@ -21,18 +21,28 @@ enum class CustomMsgTypes : uint32_t {
 class CustomClient : public custom_netlib::ClientBaseInterface<CustomMsgTypes> {
 public:
   void PingServer() {
+    // the ping is a request, so the response is matched by its correlation
+    // id and the round trip time is measured with the local clock only
     custom_netlib::message<CustomMsgTypes> msg;
     msg.header.id = CustomMsgTypes::ServerPing;
 
-    std::chrono::system_clock::time_point now_pc_clock =
-        std::chrono::system_clock::
-            now(); // CAUTION: Only works properly if the server host and the
-                   // client host has the same system clock sent this to the
-                   // server and he will it back to you so we can calculate the
-                   // round trip time in the upcoming lines of code
-    msg << now_pc_clock;
-
-    Send(msg);
+    std::chrono::steady_clock::time_point request_time =
+        std::chrono::steady_clock::now();
+    Request(
+        std::move(msg), std::chrono::seconds(5),
+        [request_time](custom_netlib::RequestStatus status,
+                       custom_netlib::message<CustomMsgTypes> &&) {
+          if (status != custom_netlib::RequestStatus::Ok) {
+            std::cout << "Ping failed!\n";
+            return;
+          }
+          std::cout << "Ping: "
+                    << std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - request_time)
+                           .count()
+                    << "\n";
+        },
+        custom_netlib::MessagePriority::High);
   }
 
   void MessageAll() {
@@ -105,6 +115,21 @@ int main(int argc, const char *argv[]) {
   //client.Connect("127.0.0.1", 60000);
   client.Connect(ip_addr, port_num); 
 
+  // handlers for the messages from the server, called by client.update()
+  client.messageHandlers().onPayload<uint32_t>(
+      CustomMsgTypes::MessageAll, [](const uint32_t &clientID) {
+        std::cout << "Hello from [" << clientID << "]\n";
+      });
+  client.messageHandlers().on(
+      CustomMsgTypes::ServerAccept,
+      [](custom_netlib::message<CustomMsgTypes> &) {
+        std::cout << "Server accepted connection.\n";
+      });
+  client.messageHandlers().onUnhandled(
+      [](custom_netlib::message<CustomMsgTypes> &) {
+        std::cout << "Default case!\n";
+      });
+
   char input_character =
       'y'; // default value to not get randomly blocked since we are not under
            // contol whats in the memory before we allocate it
@@ -165,50 +190,11 @@ int main(int argc, const char *argv[]) {
     } else {
       // if we do not want to request something from the server, we want to
       // check if he sends us some messages (maybe back after we requested
-      // something before)
-      if (client.isConnected()) {
-        if (!client.Incoming().isEmpty()) {
-          // The incoming message queue is not empty, so we want to read some
-          // messages
-
-          auto msg_from_server = client.Incoming().popFront().msg;
-          switch (msg_from_server.header.id) {
-
-          case CustomMsgTypes::ServerPing: {
-            std::chrono::system_clock::time_point response_time =
-                std::chrono::system_clock::now();
-            std::chrono::system_clock::time_point request_time;
-            msg_from_server >> request_time;
-            std::cout << "Ping: "
-                      << std::chrono::duration<double>(response_time -
-                                                       request_time)
-                             .count()
-                      << "\n";
-            break;
-          }
-
-          case CustomMsgTypes::MessageAll: {
-            uint32_t clientID;
-            msg_from_server >> clientID;
-            std::cout << "Hello from [" << clientID << "]\n";
-            break;
-          }
-
-          case CustomMsgTypes::ServerAccept: {
-            std::cout << "Server accepted connection.\n";
-            break;
-          }
-
-          default: {
-            std::cout << "Default case!\n";
-            break;
-          }
-          }
-
-        } else {
-          std::this_thread::sleep_for(
-              std::chrono::milliseconds(200)); // to not burn down the processor
-        }
+      // something before). The thread sleeps until a message arrives (and
+      // reacts to it right away) or until it is time to look at the keyboard
+      // input again
+      if (client.waitForMessage(std::chrono::milliseconds(20))) {
+        client.update();
       }
     }
   }
@@ -13,10 +13,39 @@ enum class CustomMsgTypes : uint32_t {
 class CustomServerLogic
     : public custom_netlib::ServerInterfaceClass<CustomMsgTypes> {
 public:
-  CustomServerLogic(uint16_t n_port)
-      : custom_netlib::ServerInterfaceClass<CustomMsgTypes>(n_port) {
+  CustomServerLogic(uint16_t n_port, const custom_netlib::ServerConfig &config =
+                                         custom_netlib::ServerConfig())
+      : custom_netlib::ServerInterfaceClass<CustomMsgTypes>(n_port, config) {
     // Initializer list constructs the server interface with the given port
     // number
+
+    // one handler per message type instead of a switch within onMessage
+    messageHandlers().on(
+        CustomMsgTypes::ServerPing,
+        [](const std::shared_ptr<
+               custom_netlib::ConnectionInterface<CustomMsgTypes>> &client,
+           custom_netlib::message<CustomMsgTypes> &msg_input) {
+          std::cout << "[" << client->getID() << "]: Server ping\n";
+          // the response carries the correlation id of the request. It is
+          // answered in the priority lane, so the RTT does not include the
+          // time the ping would wait behind queued bulk data
+          custom_netlib::message<CustomMsgTypes> response =
+              custom_netlib::makeResponse(msg_input);
+          client->SendData(std::move(response),
+                           custom_netlib::MessagePriority::High);
+        });
+
+    messageHandlers().on(
+        CustomMsgTypes::MessageAll,
+        [this](const std::shared_ptr<
+                   custom_netlib::ConnectionInterface<CustomMsgTypes>> &client,
+               custom_netlib::message<CustomMsgTypes> &) {
+          std::cout << "[" << client->getID() << "]: Message all\n";
+          custom_netlib::message<CustomMsgTypes> msg;
+          msg.header.id = CustomMsgTypes::MessageAll;
+          msg << client->getID();
+          sendMessageToAllClients(msg, client); // just return the header
+        });
   }
 
 protected:
@@ -26,7 +55,7 @@ protected:
           client_ptr) {
     custom_netlib::message<CustomMsgTypes> msg;
     msg.header.id = CustomMsgTypes::ServerAccept;
-    client_ptr->SendData(msg);
+    client_ptr->SendData(msg, custom_netlib::MessagePriority::High);
     return true; // accept all requested client connections
   }
 
@@ -35,31 +64,6 @@ protected:
           client_ptr) {
     std::cout << "Removing client [" << client_ptr->getID() << "]\n";
   }
-
-  virtual void
-  onMessage(std::shared_ptr<custom_netlib::ConnectionInterface<CustomMsgTypes>>
-                client,
-            custom_netlib::message<CustomMsgTypes> &msg_input) {
-    switch (msg_input.header.id) {
-
-    case CustomMsgTypes::ServerPing: {
-      std::cout << "[" << client->getID() << "]: Server ping\n";
-      client->SendData(msg_input);
-      break;
-    }
-
-    case CustomMsgTypes::MessageAll: {
-      std::cout << "[" << client->getID() << "]: Message all\n";
-      custom_netlib::message<CustomMsgTypes> msg;
-      msg.header.id = CustomMsgTypes::MessageAll;
-      msg << client->getID();
-      sendMessageToAllClients(msg, client); // just return the header
-      break;
-    }
-
-    default: { break; }
-    }
-  }
 };
 
 int main(int argc, const char *argv[]) {
@@ -74,7 +78,23 @@ int main(int argc, const char *argv[]) {
         "help,h", "Help and overview of all possible command line options")(
         "port,p",
         boost::program_options::value<uint32_t>()->default_value(60000),
-        "Port where the server should listen for new connections from clients.");
+        "Port where the server should listen for new connections from clients.")(
+        "threads,t",
+        boost::program_options::value<size_t>()->default_value(1),
+        "Number of I/O threads that handle the client connections.")(
+        "reuse-port,r",
+        "Every I/O thread accepts its own connections (SO_REUSEPORT).")(
+        "workers,w",
+        boost::program_options::value<size_t>()->default_value(0),
+        "Number of worker threads for the message handling (0: main thread).")(
+        "heartbeat-ms",
+        boost::program_options::value<uint32_t>()->default_value(0),
+        "Heartbeat interval for quiet clients in milliseconds (0: off).")(
+        "idle-timeout-ms",
+        boost::program_options::value<uint32_t>()->default_value(0),
+        "Disconnect clients that were quiet this long (0: off).")(
+        "inline-ping",
+        "Answer pings directly within the I/O threads (no queue hop).");
 
     boost::program_options::store(
         boost::program_options::parse_command_line(argc, argv, desc), vm);
@@ -87,14 +107,42 @@ int main(int argc, const char *argv[]) {
       exit(0);
   }
 
+  custom_netlib::ServerConfig server_config;
+  server_config.num_io_threads = vm["threads"].as<size_t>();
+  server_config.reuse_port_acceptors = vm.count("reuse-port") > 0;
+  server_config.num_message_workers = vm["workers"].as<size_t>();
+  server_config.heartbeat_interval =
+      std::chrono::milliseconds(vm["heartbeat-ms"].as<uint32_t>());
+  server_config.idle_timeout =
+      std::chrono::milliseconds(vm["idle-timeout-ms"].as<uint32_t>());
+  server_config.num_message_ids =
+      size_t(CustomMsgTypes::ServerMessage) + 1; // the handler table
+  server_config.connection.max_out_priority_messages =
+      1024; // ping answers of a client that does not read
+
   //CustomServerLogic server_test(60000);
-  CustomServerLogic server_test(port_num); 
+  CustomServerLogic server_test(port_num, server_config); 
+  if (vm.count("inline-ping")) {
+    server_test.setInlineDispatch(CustomMsgTypes::ServerPing);
+  }
   server_test.Start();
 
   custom_netlib::message<CustomMsgTypes> msg_test;
 
   std::cout << "Server was successfully created and already started!\n";
 
+  if (server_config.num_message_workers > 0) {
+    // the workers process the messages, so we just report their queue depths
+    while (true) {
+      std::this_thread::sleep_for(std::chrono::seconds(5));
+      std::cout << "[SERVER]: worker queue depths:";
+      for (size_t depth : server_test.messageWorkerQueueDepths()) {
+        std::cout << " " << depth;
+      }
+      std::cout << "\n";
+    }
+  }
+
   while (true) {
     server_test.update(-1, true);
   }
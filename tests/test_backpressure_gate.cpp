@@ -0,0 +1,34 @@
+#include "net_backpressure_gate.hpp"
+#include <gtest/gtest.h>
+
+TEST(backpressure_gate_test_case, pause_and_resume_test) {
+
+  custom_netlib::BackpressureGate gate(4); // resumes at 2 pending messages
+  size_t num_resumed = 0;
+
+  gate.added(3);
+  EXPECT_FALSE(gate.saturated());
+  gate.added();
+  EXPECT_TRUE(gate.saturated());
+
+  EXPECT_TRUE(gate.waitForCapacity([&num_resumed]() { num_resumed++; }));
+  EXPECT_TRUE(gate.waitForCapacity([&num_resumed]() { num_resumed++; }));
+  EXPECT_EQ(gate.numWaiting(), 2u);
+  EXPECT_EQ(gate.numPauses(), 2u);
+
+  // below the high-water mark, but not yet at the resume mark
+  gate.consumed();
+  EXPECT_FALSE(gate.saturated());
+  EXPECT_EQ(num_resumed, 0u);
+
+  gate.consumed();
+  EXPECT_EQ(num_resumed, 2u);
+  EXPECT_EQ(gate.numWaiting(), 0u);
+  EXPECT_EQ(gate.pending(), 2u);
+
+  // nothing to wait for if the consumers already caught up
+  EXPECT_FALSE(gate.waitForCapacity([&num_resumed]() { num_resumed++; }));
+  EXPECT_EQ(gate.numWaiting(), 0u);
+  gate.consumed(2);
+  EXPECT_EQ(num_resumed, 2u);
+}
@@ -0,0 +1,42 @@
+#include "net_circular_buffer.hpp"
+#include <gtest/gtest.h>
+
+TEST(circular_buffer_test_case, wrap_around_test) {
+
+  custom_netlib::CircularBuffer ring(8);
+
+  // fill 6 of the 8 bytes and consume 4 of them, so the next write needs to
+  // wrap around the end of the underlying memory
+  const uint8_t first_data[6] = {0, 1, 2, 3, 4, 5};
+  boost::asio::buffer_copy(ring.prepare(6), boost::asio::buffer(first_data));
+  ring.commit(6);
+  ring.consume(4);
+  EXPECT_EQ(ring.size(), 2u);
+
+  // 6 bytes of free space are split into two buffers (end and front of the
+  // memory)
+  auto free_space = ring.prepare();
+  EXPECT_EQ(free_space.size(), 2u);
+  EXPECT_EQ(boost::asio::buffer_size(free_space), 6u);
+
+  const uint8_t second_data[6] = {6, 7, 8, 9, 10, 11};
+  boost::asio::buffer_copy(free_space, boost::asio::buffer(second_data));
+  ring.commit(6);
+  EXPECT_TRUE(ring.full());
+
+  // the readable data has to come out in the order it was written in
+  uint8_t read_data[8] = {};
+  EXPECT_EQ(boost::asio::buffer_copy(boost::asio::buffer(read_data),
+                                     ring.data()),
+            8u);
+  for (uint8_t i = 0; i < 8; i++) {
+    EXPECT_EQ(read_data[i], i + 4);
+  }
+
+  EXPECT_THROW(ring.prepare(1), std::length_error);
+
+  // an empty buffer starts over at the front of the memory
+  ring.consume(8);
+  EXPECT_EQ(ring.size(), 0u);
+  EXPECT_EQ(ring.prepare().size(), 1u);
+}
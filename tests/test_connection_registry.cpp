@@ -0,0 +1,80 @@
+#include "net_connection_registry.hpp"
+#include "net_subscription_registry.hpp"
+#include "net_ts_queue.hpp"
+#include <gtest/gtest.h>
+
+enum class RegistryMsgTypes : uint32_t { Data };
+
+TEST(connection_registry_test_case, insert_find_erase_test) {
+
+  using Connection = custom_netlib::ConnectionInterface<RegistryMsgTypes>;
+  boost::asio::io_context ioserv;
+  custom_netlib::TsNetQueue<custom_netlib::OwnedMessage<RegistryMsgTypes>>
+      in_queue;
+
+  custom_netlib::ConnectionRegistry<RegistryMsgTypes> registry;
+  std::vector<std::shared_ptr<Connection>> connections;
+  for (uint32_t id = 0; id < 4; id++) {
+    connections.emplace_back(std::make_shared<Connection>(
+        Connection::Owner::server, ioserv,
+        boost::asio::ip::tcp::socket(ioserv), in_queue));
+    EXPECT_TRUE(registry.insert(id * 10, connections.back()));
+  }
+  EXPECT_FALSE(registry.insert(10, connections[0])); // IDs are unique
+  EXPECT_EQ(registry.size(), 4u);
+
+  // removing a connection from the middle moves the last one into the gap,
+  // every remaining connection can still be found by its ID
+  EXPECT_TRUE(registry.erase(10));
+  EXPECT_FALSE(registry.erase(10));
+  EXPECT_EQ(registry.size(), 3u);
+  EXPECT_EQ(registry.find(10), nullptr);
+  EXPECT_EQ(registry.find(0), connections[0]);
+  EXPECT_EQ(registry.find(20), connections[2]);
+  EXPECT_EQ(registry.find(30), connections[3]);
+
+  size_t num_iterated = 0;
+  for (const auto &connection : registry) {
+    EXPECT_NE(connection, connections[1]);
+    num_iterated++;
+  }
+  EXPECT_EQ(num_iterated, 3u);
+
+  EXPECT_TRUE(registry.erase(30)); // last element
+  EXPECT_TRUE(registry.erase(0));
+  EXPECT_EQ(registry.find(20), connections[2]);
+  EXPECT_EQ(registry.size(), 1u);
+}
+
+TEST(connection_registry_test_case, subscription_test) {
+
+  using Connection = custom_netlib::ConnectionInterface<RegistryMsgTypes>;
+  boost::asio::io_context ioserv;
+  custom_netlib::TsNetQueue<custom_netlib::OwnedMessage<RegistryMsgTypes>>
+      in_queue;
+  auto first = std::make_shared<Connection>(
+      Connection::Owner::server, ioserv, boost::asio::ip::tcp::socket(ioserv),
+      in_queue);
+  auto second = std::make_shared<Connection>(
+      Connection::Owner::server, ioserv, boost::asio::ip::tcp::socket(ioserv),
+      in_queue);
+
+  custom_netlib::SubscriptionRegistry<RegistryMsgTypes> subscriptions;
+  EXPECT_EQ(subscriptions.subscribers(7), nullptr);
+
+  EXPECT_TRUE(subscriptions.subscribe(7, 1, first));
+  EXPECT_FALSE(subscriptions.subscribe(7, 1, first)); // already a member
+  EXPECT_TRUE(subscriptions.subscribe(7, 2, second));
+  EXPECT_TRUE(subscriptions.subscribe(8, 1, first));
+  EXPECT_EQ(subscriptions.numGroups(), 2u);
+  EXPECT_EQ(subscriptions.subscribers(7)->size(), 2u);
+
+  EXPECT_TRUE(subscriptions.unsubscribe(7, 2));
+  EXPECT_FALSE(subscriptions.unsubscribe(7, 2));
+  EXPECT_EQ(subscriptions.subscribers(7)->find(1), first);
+
+  // a disconnected client leaves all of its groups, empty groups disappear
+  EXPECT_EQ(subscriptions.unsubscribeAll(1), 2u);
+  EXPECT_EQ(subscriptions.numGroups(), 0u);
+  EXPECT_EQ(subscriptions.unsubscribeAll(1), 0u);
+}
@@ -0,0 +1,172 @@
+#include "connection_net_interface.hpp"
+#include "net_ts_queue.hpp"
+#include <gtest/gtest.h>
+
+enum class FragmentMsgTypes : uint32_t { Small, Bulk };
+
+using FragmentConnection = custom_netlib::ConnectionInterface<FragmentMsgTypes>;
+
+class fragmentation_test_case : public ::testing::Test {
+protected:
+  // the connection only needs the validation callback of its server
+  struct ValidatingServer {
+    void onClientValidated(std::shared_ptr<FragmentConnection>) {}
+  };
+
+  void connect(const custom_netlib::ConnectionConfig &client_config,
+               const custom_netlib::ConnectionConfig &server_config) {
+    // connects a client and a server connection over loopback (including the
+    // handshake), both run within the io_context of the test
+    boost::asio::ip::tcp::acceptor acceptor(
+        ioserv_, boost::asio::ip::tcp::endpoint(
+                     boost::asio::ip::make_address("127.0.0.1"), 0));
+    acceptor.async_accept([this, server_config](
+                              boost::system::error_code ec,
+                              boost::asio::ip::tcp::socket sock) {
+      ASSERT_FALSE(ec);
+      server_ = std::make_shared<FragmentConnection>(
+          FragmentConnection::Owner::server, ioserv_, std::move(sock),
+          server_in_queue_, server_config);
+      server_->ConnectToClient(&validating_server_, 1);
+    });
+
+    client_ = std::make_shared<FragmentConnection>(
+        FragmentConnection::Owner::client, ioserv_,
+        boost::asio::ip::tcp::socket(ioserv_), client_in_queue_, client_config);
+    boost::asio::ip::tcp::resolver resolver(ioserv_);
+    client_->ConnectToServer(resolver.resolve(
+        "127.0.0.1", std::to_string(acceptor.local_endpoint().port())));
+    runUntil([this]() { return server_ != nullptr; });
+  }
+
+  template <typename Predicate> void runUntil(Predicate done) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!done() && std::chrono::steady_clock::now() < deadline) {
+      ioserv_.run_for(std::chrono::milliseconds(10));
+      ioserv_.restart();
+    }
+  }
+
+  static custom_netlib::message<FragmentMsgTypes> makeBulk(size_t bytes) {
+    custom_netlib::message<FragmentMsgTypes> msg;
+    msg.header.id = FragmentMsgTypes::Bulk;
+    msg.payload.resize(bytes);
+    for (size_t i = 0; i < bytes; i++) {
+      msg.payload.data()[i] = uint8_t(i * 7);
+    }
+    msg.header.size = uint32_t(bytes);
+    return msg;
+  }
+
+  boost::asio::io_context ioserv_;
+  ValidatingServer validating_server_;
+  std::shared_ptr<FragmentConnection> server_;
+  std::shared_ptr<FragmentConnection> client_;
+  custom_netlib::TsNetQueue<custom_netlib::OwnedMessage<FragmentMsgTypes>>
+      server_in_queue_;
+  custom_netlib::TsNetQueue<custom_netlib::OwnedMessage<FragmentMsgTypes>>
+      client_in_queue_;
+};
+
+TEST_F(fragmentation_test_case, reassembly_test) {
+
+  custom_netlib::ConnectionConfig config;
+  config.max_frame_bytes = 4096;
+  connect(config, config);
+
+  // a message of 256 frames between two small messages
+  custom_netlib::message<FragmentMsgTypes> small;
+  small.header.id = FragmentMsgTypes::Small;
+  small << uint32_t(42);
+  client_->SendData(small);
+  client_->SendData(makeBulk(1024 * 1024));
+  client_->SendData(small);
+  runUntil([this]() { return server_in_queue_.count() == 3; });
+
+  ASSERT_EQ(server_in_queue_.count(), 3u);
+  EXPECT_EQ(server_in_queue_.popFront().msg.header.id, FragmentMsgTypes::Small);
+  custom_netlib::message<FragmentMsgTypes> bulk =
+      server_in_queue_.popFront().msg;
+  EXPECT_EQ(bulk.header.id, FragmentMsgTypes::Bulk);
+  EXPECT_EQ(bulk.header.flags, 0u);
+  ASSERT_EQ(bulk.payload.size(), 1024u * 1024u);
+  EXPECT_TRUE(std::equal(bulk.payload.data(),
+                         bulk.payload.data() + bulk.payload.size(),
+                         makeBulk(1024 * 1024).payload.data()));
+  EXPECT_EQ(server_in_queue_.popFront().msg.header.id, FragmentMsgTypes::Small);
+  EXPECT_TRUE(server_->IsConnected());
+}
+
+TEST_F(fragmentation_test_case, frame_limit_test) {
+
+  // the sender does not split the message, the receiver rejects the frame
+  custom_netlib::ConnectionConfig sender_config;
+  sender_config.max_frame_bytes = 1024 * 1024;
+  custom_netlib::ConnectionConfig receiver_config;
+  receiver_config.max_frame_bytes = 4096;
+  connect(sender_config, receiver_config);
+  client_->SendData(makeBulk(64 * 1024));
+  runUntil([this]() { return !server_->IsConnected(); });
+  EXPECT_FALSE(server_->IsConnected());
+  EXPECT_TRUE(server_in_queue_.isEmpty());
+}
+
+TEST_F(fragmentation_test_case, message_limit_test) {
+
+  // the fragments are fine, but the announced message is too large
+  custom_netlib::ConnectionConfig sender_config;
+  sender_config.max_frame_bytes = 4096;
+  custom_netlib::ConnectionConfig receiver_config;
+  receiver_config.max_message_bytes = 32 * 1024;
+  connect(sender_config, receiver_config);
+  client_->SendData(makeBulk(64 * 1024));
+  runUntil([this]() { return !server_->IsConnected(); });
+  EXPECT_FALSE(server_->IsConnected());
+  EXPECT_TRUE(server_in_queue_.isEmpty());
+}
+
+TEST_F(fragmentation_test_case, priority_lane_test) {
+
+  custom_netlib::ConnectionConfig config;
+  config.max_frame_bytes = 4096;
+  connect(config, config);
+
+  // the high priority message overtakes the fragments of the bulk message
+  // that are not written yet
+  custom_netlib::message<FragmentMsgTypes> small;
+  small.header.id = FragmentMsgTypes::Small;
+  small << uint32_t(42);
+  client_->SendData(makeBulk(1024 * 1024));
+  client_->SendData(small, custom_netlib::MessagePriority::High);
+  runUntil([this]() { return server_in_queue_.count() == 2; });
+
+  ASSERT_EQ(server_in_queue_.count(), 2u);
+  EXPECT_EQ(server_in_queue_.popFront().msg.header.id, FragmentMsgTypes::Small);
+  EXPECT_EQ(server_in_queue_.popFront().msg.payload.size(), 1024u * 1024u);
+}
+
+TEST_F(fragmentation_test_case, write_batch_limit_test) {
+
+  // two frames (header and payload buffer each) per write
+  custom_netlib::ConnectionConfig config;
+  config.max_write_batch_buffers = 4;
+  connect(config, config);
+
+  custom_netlib::message<FragmentMsgTypes> small;
+  small.header.id = FragmentMsgTypes::Small;
+  small << uint32_t(42);
+  client_->SendData(small);
+  runUntil([this]() { return server_in_queue_.count() == 1; });
+  ASSERT_EQ(server_in_queue_.count(), 1u); // the handshake is done
+
+  FragmentConnection::WriteStats before = client_->getWriteStats();
+  for (int i = 0; i < 10; i++) {
+    client_->SendData(small);
+  }
+  runUntil([this]() { return server_in_queue_.count() == 11; });
+  ASSERT_EQ(server_in_queue_.count(), 11u);
+
+  FragmentConnection::WriteStats after = client_->getWriteStats();
+  EXPECT_EQ(after.num_frames - before.num_frames, 10u);
+  EXPECT_GE(after.num_writes - before.num_writes, 5u);
+}
@@ -0,0 +1,28 @@
+#include "net_io_context_pool.hpp"
+#include <future>
+#include <gtest/gtest.h>
+
+TEST(io_context_pool_test_case, round_robin_test) {
+
+  custom_netlib::IoContextPool pool(3);
+  EXPECT_EQ(pool.size(), 3u);
+
+  // new connections are spread over all I/O service objects one after another
+  EXPECT_EQ(&pool.query(), &pool.at(0));
+  EXPECT_EQ(&pool.query(), &pool.at(1));
+  EXPECT_EQ(&pool.query(), &pool.at(2));
+  EXPECT_EQ(&pool.query(), &pool.at(0));
+
+  // every I/O service object runs its handlers within its own thread
+  pool.run();
+  std::promise<std::thread::id> first_thread;
+  std::promise<std::thread::id> second_thread;
+  boost::asio::post(pool.at(0), [&first_thread]() {
+    first_thread.set_value(std::this_thread::get_id());
+  });
+  boost::asio::post(pool.at(1), [&second_thread]() {
+    second_thread.set_value(std::this_thread::get_id());
+  });
+  EXPECT_NE(first_thread.get_future().get(), second_thread.get_future().get());
+  pool.stop();
+}
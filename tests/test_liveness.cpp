@@ -0,0 +1,63 @@
+#include "net_client.hpp"
+#include "net_server.hpp"
+#include <gtest/gtest.h>
+
+enum class LivenessMsgTypes : uint32_t { Any };
+
+using LivenessConnection = custom_netlib::ConnectionInterface<LivenessMsgTypes>;
+
+class ReapingServer
+    : public custom_netlib::ServerInterfaceClass<LivenessMsgTypes> {
+public:
+  ReapingServer(const custom_netlib::ServerConfig &server_config)
+      : custom_netlib::ServerInterfaceClass<LivenessMsgTypes>(0,
+                                                              server_config) {}
+
+  std::promise<std::weak_ptr<LivenessConnection>> validated;
+  std::promise<void> disconnected;
+
+protected:
+  bool onClientConnect(std::shared_ptr<LivenessConnection>) override {
+    return true;
+  }
+
+  void onClientValidated(std::shared_ptr<LivenessConnection> client) override {
+    validated.set_value(client);
+  }
+
+  void onClientDisconnect(std::shared_ptr<LivenessConnection>) override {
+    disconnected.set_value();
+  }
+};
+
+TEST(liveness_test_case, reap_idle_client_test) {
+
+  // the client never sends anything, so the server closes the connection
+  // after the idle timeout and drops it from its registry while the read of
+  // the connection is still pending
+  custom_netlib::ServerConfig server_config;
+  server_config.idle_timeout = std::chrono::milliseconds(100);
+  server_config.timer_wheel_tick = std::chrono::milliseconds(10);
+  ReapingServer server(server_config);
+  ASSERT_TRUE(server.Start());
+
+  custom_netlib::ClientBaseInterface<LivenessMsgTypes> client;
+  ASSERT_TRUE(client.Connect("127.0.0.1", server.getPort()));
+
+  auto validated = server.validated.get_future();
+  ASSERT_EQ(validated.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  std::weak_ptr<LivenessConnection> connection = validated.get();
+  auto disconnected = server.disconnected.get_future();
+  ASSERT_EQ(disconnected.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+
+  // the connection is destroyed once its last handler (the aborted read) has
+  // run, not while it is still pending
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!connection.expired() &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(connection.expired());
+}
@@ -0,0 +1,65 @@
+#include "net_message_dispatcher.hpp"
+#include <gtest/gtest.h>
+
+enum class DispatchMsgTypes : uint32_t { Ping, Position, Chat, Count };
+
+struct Position {
+  float x;
+  float y;
+};
+
+TEST(message_dispatcher_test_case, dispatch_test) {
+
+  custom_netlib::MessageDispatcher<DispatchMsgTypes, int> dispatcher(
+      size_t(DispatchMsgTypes::Count));
+  int last_context = 0;
+  float last_x = 0;
+  size_t num_unhandled = 0;
+
+  dispatcher.on(DispatchMsgTypes::Ping,
+                [&last_context](int context,
+                                custom_netlib::message<DispatchMsgTypes> &) {
+                  last_context = context;
+                });
+  dispatcher.onPayload<Position>(
+      DispatchMsgTypes::Position,
+      [&last_x](int, const Position &position) {
+        last_x = position.x;
+      });
+
+  custom_netlib::message<DispatchMsgTypes> ping;
+  ping.header.id = DispatchMsgTypes::Ping;
+  EXPECT_TRUE(dispatcher.dispatch(7, ping));
+  EXPECT_EQ(last_context, 7);
+
+  // the payload is decoded into the struct
+  custom_netlib::message<DispatchMsgTypes> position_msg;
+  position_msg.header.id = DispatchMsgTypes::Position;
+  position_msg << Position{1.5f, 2.5f};
+  EXPECT_TRUE(dispatcher.dispatch(1, position_msg));
+  EXPECT_EQ(last_x, 1.5f);
+
+  // a payload of the wrong size is dropped
+  custom_netlib::message<DispatchMsgTypes> short_msg;
+  short_msg.header.id = DispatchMsgTypes::Position;
+  short_msg << uint32_t(1);
+  EXPECT_TRUE(dispatcher.dispatch(1, short_msg));
+  EXPECT_EQ(dispatcher.numMalformed(), 1u);
+
+  // ids without a handler
+  custom_netlib::message<DispatchMsgTypes> chat;
+  chat.header.id = DispatchMsgTypes::Chat;
+  EXPECT_FALSE(dispatcher.dispatch(1, chat));
+  dispatcher.onUnhandled(
+      [&num_unhandled](int, custom_netlib::message<DispatchMsgTypes> &) {
+        num_unhandled++;
+      });
+  EXPECT_TRUE(dispatcher.dispatch(1, chat));
+  EXPECT_EQ(num_unhandled, 1u);
+
+  // handlers can be replaced and removed at runtime
+  dispatcher.on(DispatchMsgTypes::Ping, nullptr);
+  EXPECT_TRUE(dispatcher.dispatch(9, ping));
+  EXPECT_EQ(last_context, 7);
+  EXPECT_EQ(num_unhandled, 2u);
+}
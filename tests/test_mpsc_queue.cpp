@@ -0,0 +1,131 @@
+#include "net_client.hpp"
+#include "net_mpsc_queue.hpp"
+#include "net_server.hpp"
+#include <gtest/gtest.h>
+
+TEST(mpsc_queue_test_case, multi_producer_order_test) {
+
+  custom_netlib::LockFreeMpscQueue<std::pair<int, int>> queue;
+  const int num_producers = 4;
+  const int num_elements = 10000;
+
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < num_producers; producer++) {
+    producers.emplace_back([&queue, producer]() {
+      for (int i = 0; i < num_elements; i++) {
+        queue.emplaceBack(producer, i);
+      }
+    });
+  }
+
+  // the consumer runs concurrently with the producers, the elements of every
+  // producer arrive in the order they were pushed
+  std::vector<int> next_element(num_producers, 0);
+  std::deque<std::pair<int, int>> batch;
+  int num_received = 0;
+  while (num_received < num_producers * num_elements) {
+    if (!queue.waitFor(std::chrono::seconds(5))) {
+      break;
+    }
+    num_received += int(queue.drain(batch));
+    for (const auto &element : batch) {
+      EXPECT_EQ(element.second, next_element[element.first]++);
+    }
+    batch.clear();
+  }
+  for (auto &producer : producers) {
+    producer.join();
+  }
+
+  EXPECT_EQ(num_received, num_producers * num_elements);
+  EXPECT_TRUE(queue.isEmpty());
+}
+
+TEST(mpsc_queue_test_case, batch_limit_test) {
+
+  custom_netlib::LockFreeMpscQueue<int> queue;
+  for (int i = 0; i < 10; i++) {
+    queue.pushBack(i);
+  }
+
+  std::vector<int> batch;
+  EXPECT_EQ(queue.drain(batch, 3), 3u);
+  EXPECT_EQ(queue.popUpTo(4, batch), 4u);
+  EXPECT_EQ(batch, (std::vector<int>{0, 1, 2, 3, 4, 5, 6}));
+  EXPECT_EQ(queue.count(), 3u);
+
+  EXPECT_EQ(queue.popUpTo(10, batch), 3u); // only three left
+  EXPECT_EQ(queue.drain(batch), 0u);
+  EXPECT_EQ(batch.size(), 10u);
+  EXPECT_FALSE(queue.tryPopFront());
+}
+
+TEST(mpsc_queue_test_case, wait_for_test) {
+
+  custom_netlib::LockFreeMpscQueue<int> queue;
+  auto t_start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(queue.waitFor(std::chrono::milliseconds(20)));
+  EXPECT_GE(std::chrono::steady_clock::now() - t_start,
+            std::chrono::milliseconds(20));
+
+  // a push from another thread wakes the sleeping consumer up
+  std::thread producer([&queue]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.pushBack(42);
+  });
+  EXPECT_TRUE(queue.waitFor(std::chrono::seconds(5)));
+  EXPECT_EQ(queue.popFront(), 42);
+  producer.join();
+}
+
+enum class MpscMsgTypes : uint32_t { Echo };
+
+class MpscEchoServer
+    : public custom_netlib::ServerInterfaceClass<
+          MpscMsgTypes, custom_netlib::LockFreeMpscQueue> {
+public:
+  MpscEchoServer()
+      : custom_netlib::ServerInterfaceClass<MpscMsgTypes,
+                                            custom_netlib::LockFreeMpscQueue>(
+            0) {}
+
+protected:
+  bool onClientConnect(
+      std::shared_ptr<custom_netlib::ConnectionInterface<MpscMsgTypes>>)
+      override {
+    return true;
+  }
+
+  void onMessage(
+      std::shared_ptr<custom_netlib::ConnectionInterface<MpscMsgTypes>> client,
+      custom_netlib::message<MpscMsgTypes> &msg_input) override {
+    client->SendData(std::move(msg_input));
+  }
+};
+
+TEST(mpsc_queue_test_case, server_round_trip_test) {
+
+  MpscEchoServer server;
+  ASSERT_TRUE(server.Start());
+  custom_netlib::ClientBaseInterface<MpscMsgTypes> client;
+  ASSERT_TRUE(client.Connect("127.0.0.1", server.getPort()));
+
+  custom_netlib::message<MpscMsgTypes> echo;
+  echo.header.id = MpscMsgTypes::Echo;
+  echo << uint32_t(42);
+  client.Send(echo);
+
+  // this thread is the single consumer of the incoming queue of the server
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (client.Incoming().isEmpty() &&
+         std::chrono::steady_clock::now() < deadline) {
+    server.update(-1, false);
+    client.waitForMessage(std::chrono::milliseconds(1));
+  }
+  ASSERT_FALSE(client.Incoming().isEmpty());
+  custom_netlib::message<MpscMsgTypes> response =
+      client.Incoming().popFront().msg;
+  uint32_t value = 0;
+  response >> value;
+  EXPECT_EQ(value, 42u);
+}
@@ -0,0 +1,205 @@
+#include "connection_net_interface.hpp"
+#include "net_client.hpp"
+#include "net_server.hpp"
+#include "net_ts_queue.hpp"
+#include <gtest/gtest.h>
+
+enum class PolicyMsgTypes : uint32_t { Position, Chat };
+
+using PolicyConnection = custom_netlib::ConnectionInterface<PolicyMsgTypes>;
+
+class out_queue_policy_test_case : public ::testing::Test {
+protected:
+  std::shared_ptr<PolicyConnection>
+  makeConnection(custom_netlib::OutQueuePolicy policy,
+                 size_t max_out_queue_bytes = 0,
+                 size_t max_out_priority_messages = 0) {
+    // The handshake of the connection never happens, so all queued messages
+    // stay within the out queue (like for a client that stopped reading)
+    custom_netlib::ConnectionConfig config;
+    config.max_out_queue_messages = 3;
+    config.max_out_queue_bytes = max_out_queue_bytes;
+    config.max_out_priority_messages = max_out_priority_messages;
+    config.out_queue_policy = policy;
+    boost::asio::ip::tcp::socket sock(ioserv_);
+    sock.open(boost::asio::ip::tcp::v4());
+    auto connection = std::make_shared<PolicyConnection>(
+        PolicyConnection::Owner::server, ioserv_, std::move(sock), in_queue_,
+        config);
+    connection->SetOutQueueFullHandler([this]() { num_full_events_++; });
+    return connection;
+  }
+
+  static custom_netlib::SharedMessage<PolicyMsgTypes>
+  makeMsg(PolicyMsgTypes id) {
+    custom_netlib::message<PolicyMsgTypes> msg;
+    msg.header.id = id;
+    msg << uint32_t(42);
+    return custom_netlib::makeSharedMessage(std::move(msg));
+  }
+
+  boost::asio::io_context ioserv_;
+  custom_netlib::TsNetQueue<custom_netlib::OwnedMessage<PolicyMsgTypes>>
+      in_queue_;
+  size_t num_full_events_ = 0;
+};
+
+TEST_F(out_queue_policy_test_case, drop_test) {
+
+  auto drop_oldest = makeConnection(custom_netlib::OutQueuePolicy::DropOldest);
+  for (int i = 0; i < 5; i++) {
+    drop_oldest->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  }
+  EXPECT_EQ(drop_oldest->OutQueueSize(), 3u);
+  EXPECT_EQ(drop_oldest->getOutQueueStats().num_dropped, 2u);
+
+  auto drop_newest = makeConnection(custom_netlib::OutQueuePolicy::DropNewest);
+  for (int i = 0; i < 5; i++) {
+    drop_newest->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  }
+  EXPECT_EQ(drop_newest->OutQueueSize(), 3u);
+  EXPECT_EQ(drop_newest->getOutQueueStats().num_dropped, 2u);
+
+  // the handler is called once per connection when the mark is reached (it
+  // is posted to the I/O service object)
+  EXPECT_EQ(num_full_events_, 0u);
+  ioserv_.poll();
+  EXPECT_EQ(num_full_events_, 2u);
+}
+
+TEST_F(out_queue_policy_test_case, oversized_message_test) {
+
+  // room for two small messages (16 byte header + 4 byte payload each)
+  auto drop_oldest =
+      makeConnection(custom_netlib::OutQueuePolicy::DropOldest, 40);
+  drop_oldest->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  drop_oldest->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+
+  // the large message is dropped instead of the queued ones
+  custom_netlib::message<PolicyMsgTypes> large;
+  large.header.id = PolicyMsgTypes::Chat;
+  large.payload.resize(64);
+  large.header.size = 64;
+  drop_oldest->QueueMessage(custom_netlib::makeSharedMessage(large));
+  EXPECT_EQ(drop_oldest->OutQueueSize(), 2u);
+  EXPECT_EQ(drop_oldest->getOutQueueStats().num_dropped, 1u);
+
+  // a message that fits still replaces the oldest one
+  drop_oldest->QueueMessage(makeMsg(PolicyMsgTypes::Position));
+  EXPECT_EQ(drop_oldest->OutQueueSize(), 2u);
+  EXPECT_EQ(drop_oldest->getOutQueueStats().num_dropped, 2u);
+}
+
+TEST_F(out_queue_policy_test_case, priority_lane_test) {
+
+  constexpr custom_netlib::MessagePriority kHigh =
+      custom_netlib::MessagePriority::High;
+
+  // high priority messages count against the marks of the queue
+  auto drop_newest = makeConnection(custom_netlib::OutQueuePolicy::DropNewest);
+  for (int i = 0; i < 5; i++) {
+    drop_newest->QueueMessage(makeMsg(PolicyMsgTypes::Position), kHigh);
+  }
+  EXPECT_EQ(drop_newest->OutQueueSize(), 3u);
+  EXPECT_EQ(drop_newest->getOutQueueStats().num_dropped, 2u);
+
+  // a high priority message pushes out the normal ones first
+  auto drop_oldest = makeConnection(custom_netlib::OutQueuePolicy::DropOldest);
+  for (int i = 0; i < 3; i++) {
+    drop_oldest->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  }
+  for (int i = 0; i < 5; i++) {
+    drop_oldest->QueueMessage(makeMsg(PolicyMsgTypes::Position), kHigh);
+  }
+  EXPECT_EQ(drop_oldest->OutQueueSize(), 3u);
+  EXPECT_EQ(drop_oldest->getOutQueueStats().num_dropped, 5u);
+
+  // the lane has its own mark, which does not affect the normal messages
+  auto lane_limit =
+      makeConnection(custom_netlib::OutQueuePolicy::DropOldest, 0, 1);
+  lane_limit->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  lane_limit->QueueMessage(makeMsg(PolicyMsgTypes::Position), kHigh);
+  lane_limit->QueueMessage(makeMsg(PolicyMsgTypes::Position), kHigh);
+  EXPECT_EQ(lane_limit->OutQueueSize(), 2u);
+  EXPECT_EQ(lane_limit->getOutQueueStats().num_dropped, 1u);
+
+  // control frames are never limited
+  lane_limit->SendHeartbeat();
+  EXPECT_EQ(lane_limit->OutQueueSize(), 3u);
+}
+
+TEST_F(out_queue_policy_test_case, coalesce_and_disconnect_test) {
+
+  auto coalesce = makeConnection(custom_netlib::OutQueuePolicy::CoalesceById);
+  coalesce->QueueMessage(makeMsg(PolicyMsgTypes::Position));
+  coalesce->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  coalesce->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  for (int i = 0; i < 10; i++) {
+    // newer positions replace the queued one
+    coalesce->QueueMessage(makeMsg(PolicyMsgTypes::Position));
+  }
+  EXPECT_EQ(coalesce->OutQueueSize(), 3u);
+  EXPECT_EQ(coalesce->getOutQueueStats().num_coalesced, 10u);
+  EXPECT_EQ(coalesce->getOutQueueStats().num_dropped, 0u);
+
+  auto disconnect = makeConnection(custom_netlib::OutQueuePolicy::Disconnect);
+  for (int i = 0; i < 4; i++) {
+    disconnect->QueueMessage(makeMsg(PolicyMsgTypes::Chat));
+  }
+  EXPECT_FALSE(disconnect->IsConnected());
+}
+
+class SlowConsumerServer
+    : public custom_netlib::ServerInterfaceClass<PolicyMsgTypes> {
+public:
+  SlowConsumerServer(const custom_netlib::ServerConfig &server_config)
+      : custom_netlib::ServerInterfaceClass<PolicyMsgTypes>(0, server_config) {}
+
+  static constexpr uint32_t kGroup = 7;
+  std::promise<bool> unsubscribed;
+
+protected:
+  bool onClientConnect(
+      std::shared_ptr<custom_netlib::ConnectionInterface<PolicyMsgTypes>>)
+      override {
+    return true;
+  }
+
+  void onClientValidated(
+      std::shared_ptr<custom_netlib::ConnectionInterface<PolicyMsgTypes>>
+          client) override {
+    // all publishes are queued before the first write completes, so the
+    // out queue of the client overflows within a fan out
+    subscribe(kGroup, client->getID());
+    custom_netlib::message<PolicyMsgTypes> msg;
+    msg.header.id = PolicyMsgTypes::Position;
+    msg << uint32_t(42);
+    for (int i = 0; i < 5; i++) {
+      publish(kGroup, msg);
+    }
+  }
+
+  void onClientOutQueueFull(
+      std::shared_ptr<custom_netlib::ConnectionInterface<PolicyMsgTypes>>
+          client) override {
+    // needs the connections mutex of the shard that published the message
+    unsubscribed.set_value(unsubscribe(kGroup, client->getID()));
+  }
+};
+
+TEST(out_queue_policy_server_test_case, unsubscribe_on_full_test) {
+
+  custom_netlib::ServerConfig server_config;
+  server_config.connection.max_out_queue_messages = 1;
+  SlowConsumerServer server(server_config);
+  ASSERT_TRUE(server.Start());
+
+  custom_netlib::ClientBaseInterface<PolicyMsgTypes> client;
+  ASSERT_TRUE(client.Connect("127.0.0.1", server.getPort()));
+
+  std::future<bool> unsubscribed = server.unsubscribed.get_future();
+  ASSERT_EQ(unsubscribed.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  EXPECT_TRUE(unsubscribed.get());
+  EXPECT_FALSE(server.unsubscribe(SlowConsumerServer::kGroup, 0));
+}
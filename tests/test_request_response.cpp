@@ -0,0 +1,240 @@
+#include "net_client.hpp"
+#include "net_server.hpp"
+#include <gtest/gtest.h>
+
+enum class RpcMsgTypes : uint32_t { Double, Ignored, Echo, Close };
+
+class RpcServer : public custom_netlib::ServerInterfaceClass<RpcMsgTypes> {
+public:
+  RpcServer(uint16_t port)
+      : custom_netlib::ServerInterfaceClass<RpcMsgTypes>(port) {
+    messageHandlers().on(
+        RpcMsgTypes::Double,
+        [](const std::shared_ptr<
+               custom_netlib::ConnectionInterface<RpcMsgTypes>> &client,
+           custom_netlib::message<RpcMsgTypes> &request) {
+          uint32_t value = 0;
+          request >> value;
+          custom_netlib::message<RpcMsgTypes> response =
+              custom_netlib::makeResponse(request);
+          response << 2 * value;
+          client->SendData(std::move(response));
+        });
+    messageHandlers().on(
+        RpcMsgTypes::Echo,
+        [](const std::shared_ptr<
+               custom_netlib::ConnectionInterface<RpcMsgTypes>> &client,
+           custom_netlib::message<RpcMsgTypes> &msg) {
+          client->SendData(msg);
+        });
+    messageHandlers().on(
+        RpcMsgTypes::Close,
+        [](const std::shared_ptr<
+               custom_netlib::ConnectionInterface<RpcMsgTypes>> &client,
+           custom_netlib::message<RpcMsgTypes> &) { client->Disconnect(); });
+  }
+
+  std::atomic<size_t> num_validated{0};
+
+  void onClientValidated(
+      std::shared_ptr<custom_netlib::ConnectionInterface<RpcMsgTypes>>)
+      override {
+    num_validated++;
+  }
+
+protected:
+  bool onClientConnect(
+      std::shared_ptr<custom_netlib::ConnectionInterface<RpcMsgTypes>>)
+      override {
+    return true;
+  }
+};
+
+class RunningRpcServer {
+  // The server listens on a port that the OS picks and a thread calls its
+  // update(). Both are stopped when the test leaves the scope (also if an
+  // assertion returns early)
+public:
+  RunningRpcServer() : server_(0) {
+    server_.Start();
+    thr_update_ = std::thread([this]() {
+      while (running_) {
+        server_.update(-1, false);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+  }
+
+  ~RunningRpcServer() {
+    running_ = false;
+    thr_update_.join();
+    server_.Stop();
+  }
+
+  RpcServer &operator*() { return server_; }
+  RpcServer *operator->() { return &server_; }
+
+private:
+  RpcServer server_;
+  std::atomic<bool> running_{true};
+  std::thread thr_update_;
+};
+
+class InspectedClient : public custom_netlib::ClientBaseInterface<RpcMsgTypes> {
+public:
+  std::pair<size_t, bool> requestTimeouts() {
+    // number of timeouts within the wheel and whether it ticks (read within
+    // the I/O thread of the client)
+    std::promise<std::pair<size_t, bool>> state;
+    boost::asio::post(ioserv_, [this, &state]() {
+      state.set_value({request_timeouts_.size(), request_timeouts_.running()});
+    });
+    return state.get_future().get();
+  }
+};
+
+TEST(request_response_test_case, pipelined_requests_test) {
+
+  RunningRpcServer server;
+  custom_netlib::ClientBaseInterface<RpcMsgTypes> client;
+  ASSERT_TRUE(client.Connect("127.0.0.1", server->getPort()));
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (server->num_validated == 0 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // many requests in flight on the same connection
+  std::vector<std::future<custom_netlib::message<RpcMsgTypes>>> responses;
+  for (uint32_t i = 0; i < 100; i++) {
+    custom_netlib::message<RpcMsgTypes> request;
+    request.header.id = RpcMsgTypes::Double;
+    request << i;
+    responses.emplace_back(
+        client.Request(std::move(request), std::chrono::seconds(5)));
+  }
+  for (uint32_t i = 0; i < 100; i++) {
+    custom_netlib::message<RpcMsgTypes> response = responses[i].get();
+    uint32_t value = 0;
+    response >> value;
+    EXPECT_EQ(value, 2 * i);
+  }
+  // responses never show up within the incoming queue
+  EXPECT_TRUE(client.Incoming().isEmpty());
+
+  // the server does not answer this request
+  custom_netlib::message<RpcMsgTypes> ignored;
+  ignored.header.id = RpcMsgTypes::Ignored;
+  std::promise<custom_netlib::RequestStatus> status;
+  client.Request(
+      std::move(ignored), std::chrono::milliseconds(50),
+      [&status](custom_netlib::RequestStatus request_status,
+                custom_netlib::message<RpcMsgTypes> &&) {
+        status.set_value(request_status);
+      });
+  EXPECT_EQ(status.get_future().get(), custom_netlib::RequestStatus::Timeout);
+}
+
+TEST(request_response_test_case, receive_notification_test) {
+
+  RunningRpcServer server;
+  custom_netlib::message<RpcMsgTypes> echo;
+  echo.header.id = RpcMsgTypes::Echo;
+  echo << uint32_t(42);
+
+  // the waiting client wakes up when the message arrives
+  custom_netlib::ClientBaseInterface<RpcMsgTypes> waiting_client;
+  ASSERT_TRUE(waiting_client.Connect("127.0.0.1", server->getPort()));
+  EXPECT_FALSE(waiting_client.waitForMessage(std::chrono::milliseconds(10)));
+  waiting_client.Send(echo);
+  EXPECT_TRUE(waiting_client.waitForMessage(std::chrono::seconds(5)));
+  EXPECT_EQ(waiting_client.Incoming().popFront().msg.header.id,
+            RpcMsgTypes::Echo);
+
+  // the callback replaces the incoming queue
+  custom_netlib::ClientBaseInterface<RpcMsgTypes> callback_client;
+  std::promise<uint32_t> received;
+  callback_client.SetMessageCallback(
+      [&received](custom_netlib::message<RpcMsgTypes> &msg) {
+        uint32_t value = 0;
+        msg >> value;
+        received.set_value(value);
+      });
+  ASSERT_TRUE(callback_client.Connect("127.0.0.1", server->getPort()));
+  callback_client.Send(echo);
+  std::future<uint32_t> value = received.get_future();
+  ASSERT_EQ(value.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+  EXPECT_EQ(value.get(), 42u);
+  EXPECT_TRUE(callback_client.Incoming().isEmpty());
+}
+
+TEST(request_response_test_case, disconnected_request_test) {
+
+  custom_netlib::message<RpcMsgTypes> request;
+  request.header.id = RpcMsgTypes::Double;
+  request << uint32_t(21);
+
+  // before Connect() and after Disconnect(), the request fails right away
+  custom_netlib::ClientBaseInterface<RpcMsgTypes> client;
+  auto before_connect = client.Request(request, std::chrono::seconds(60));
+  ASSERT_EQ(before_connect.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  EXPECT_THROW(before_connect.get(), custom_netlib::RequestFailed);
+
+  RunningRpcServer server;
+  ASSERT_TRUE(client.Connect("127.0.0.1", server->getPort()));
+  client.Disconnect();
+  custom_netlib::RequestStatus after_disconnect =
+      custom_netlib::RequestStatus::Ok;
+  client.Request(request, std::chrono::seconds(60),
+                 [&after_disconnect](custom_netlib::RequestStatus status,
+                                     custom_netlib::message<RpcMsgTypes> &&) {
+                   after_disconnect = status;
+                 });
+  EXPECT_EQ(after_disconnect, custom_netlib::RequestStatus::Disconnected);
+}
+
+TEST(request_response_test_case, closed_by_server_test) {
+
+  RunningRpcServer server;
+  custom_netlib::ClientBaseInterface<RpcMsgTypes> client;
+  ASSERT_TRUE(client.Connect("127.0.0.1", server->getPort()));
+
+  // the server closes the connection instead of answering, the request
+  // fails long before its timeout
+  custom_netlib::message<RpcMsgTypes> request;
+  request.header.id = RpcMsgTypes::Close;
+  auto response = client.Request(std::move(request), std::chrono::seconds(60));
+  ASSERT_EQ(response.wait_for(std::chrono::seconds(5)),
+            std::future_status::ready);
+  try {
+    response.get();
+    FAIL() << "the request did not fail";
+  } catch (const custom_netlib::RequestFailed &e) {
+    EXPECT_EQ(e.status(), custom_netlib::RequestStatus::Disconnected);
+  }
+}
+
+TEST(request_response_test_case, timeouts_released_test) {
+
+  RunningRpcServer server;
+  InspectedClient client;
+  ASSERT_TRUE(client.Connect("127.0.0.1", server->getPort()));
+
+  std::vector<std::future<custom_netlib::message<RpcMsgTypes>>> responses;
+  for (uint32_t i = 0; i < 100; i++) {
+    custom_netlib::message<RpcMsgTypes> request;
+    request.header.id = RpcMsgTypes::Double;
+    request << i;
+    responses.emplace_back(
+        client.Request(std::move(request), std::chrono::seconds(60)));
+  }
+  for (auto &response : responses) {
+    ASSERT_EQ(response.wait_for(std::chrono::seconds(5)),
+              std::future_status::ready);
+  }
+
+  // the answered requests leave nothing behind and the idle client does not
+  // tick anymore
+  EXPECT_EQ(client.requestTimeouts(), std::make_pair(size_t(0), false));
+}
@@ -30,4 +30,41 @@ TEST(sample_test_case, sample_test) {
   EXPECT_EQ(test_payload_1, test_returned_payload_1);
   EXPECT_EQ(test_payload_2, test_returned_payload_2);
   EXPECT_EQ(test_payload_3, test_returned_payload_3);
-}
\ No newline at end of file
+}
+TEST(sample_test_case, wire_size_test) {
+
+  enum class CustomMsgTypes : uint32_t { MsgID1, MsgID2 };
+
+  float test_payload_1 = 5.5; // 4 bytes
+  bool test_payload_2 = true; // 1 byte
+  int test_payload_3 = 3;     // 4 bytes
+
+  custom_netlib::message<CustomMsgTypes> test_msg;
+  test_msg.header.id = CustomMsgTypes::MsgID2;
+  test_msg << test_payload_1 << test_payload_2 << test_payload_3;
+
+  // the payload is byte addressed, so the header announces exactly the bytes
+  // that were pushed into the message and nothing more is sent over the wire
+  EXPECT_EQ(test_msg.header.size, 9u);
+  EXPECT_EQ(test_msg.payload.size(), 9u);
+  EXPECT_EQ(sizeof(test_msg.header) + test_msg.payload.size(), 25u);
+
+  // small messages stay within the inline storage of the message
+  EXPECT_TRUE(test_msg.payload.isInline());
+
+  // large messages move to the heap but keep their exact size
+  custom_netlib::message<CustomMsgTypes> large_msg;
+  for (uint32_t i = 0; i < 100; i++) {
+    large_msg << i;
+  }
+  EXPECT_FALSE(large_msg.payload.isInline());
+  EXPECT_EQ(large_msg.header.size, 400u);
+
+  // copies and moves keep the content
+  custom_netlib::message<CustomMsgTypes> copied_msg = large_msg;
+  custom_netlib::message<CustomMsgTypes> moved_msg = std::move(copied_msg);
+  uint32_t last_element = 0;
+  moved_msg >> last_element;
+  EXPECT_EQ(last_element, 99u);
+  EXPECT_EQ(moved_msg.header.size, 396u);
+}
@@ -0,0 +1,30 @@
+#include "net_server.hpp"
+#include <gtest/gtest.h>
+
+enum class AcceptorMsgTypes : uint32_t { Any };
+
+using AcceptorServer = custom_netlib::ServerInterfaceClass<AcceptorMsgTypes>;
+
+TEST(server_acceptor_test_case, exclusive_port_test) {
+
+  // a server with one acceptor does not share its port
+  AcceptorServer server(0);
+  EXPECT_NE(server.getPort(), 0);
+  EXPECT_THROW(AcceptorServer second_server(server.getPort()),
+               boost::system::system_error);
+}
+
+TEST(server_acceptor_test_case, reuse_port_test) {
+
+  custom_netlib::ServerConfig server_config;
+  server_config.num_io_threads = 2;
+  server_config.reuse_port_acceptors = true;
+  AcceptorServer server(0, server_config);
+  EXPECT_NE(server.getPort(), 0);
+#ifdef SO_REUSEPORT
+  // the sharded acceptors share the port with each other (and with every
+  // other process that sets SO_REUSEPORT)
+  EXPECT_NO_THROW(
+      AcceptorServer second_server(server.getPort(), server_config));
+#endif
+}
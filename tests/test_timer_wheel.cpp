@@ -0,0 +1,85 @@
+#include "net_timer_wheel.hpp"
+#include <gtest/gtest.h>
+
+TEST(timer_wheel_test_case, expiry_order_test) {
+
+  boost::asio::io_context ioserv;
+  custom_netlib::TimerWheel wheel(ioserv, std::chrono::milliseconds(2), 4);
+
+  // the delays cover less than one and more than one revolution of the wheel
+  // (4 slots * 2ms), and the same slot in different rounds
+  std::vector<int> fired;
+  wheel.schedule(std::chrono::milliseconds(20), [&]() { fired.push_back(20); });
+  wheel.schedule(std::chrono::milliseconds(4), [&]() { fired.push_back(4); });
+  wheel.schedule(std::chrono::milliseconds(12), [&]() {
+    fired.push_back(12);
+    // callbacks may schedule again (e.g. a connection that was active)
+    wheel.schedule(std::chrono::milliseconds(2), [&]() {
+      fired.push_back(14);
+      wheel.stop();
+    });
+  });
+  EXPECT_EQ(wheel.size(), 3u);
+
+  wheel.start();
+  ioserv.run(); // returns after stop(), since nothing else is left to do
+
+  EXPECT_EQ(fired, (std::vector<int>{4, 12, 14}));
+  EXPECT_EQ(wheel.size(), 1u); // the 20ms entry did not expire yet
+}
+
+TEST(timer_wheel_test_case, past_deadline_test) {
+
+  boost::asio::io_context ioserv;
+  custom_netlib::TimerWheel wheel(ioserv, std::chrono::milliseconds(2), 4);
+
+  // a deadline that is already over (e.g. an expired idle timeout) fires
+  // with the next tick
+  bool fired = false;
+  wheel.schedule(std::chrono::milliseconds(-100), [&]() {
+    fired = true;
+    wheel.stop();
+  });
+
+  wheel.start();
+  ioserv.run_for(std::chrono::seconds(1));
+
+  EXPECT_TRUE(fired);
+  EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(timer_wheel_test_case, cancel_test) {
+
+  boost::asio::io_context ioserv;
+  custom_netlib::TimerWheel wheel(ioserv, std::chrono::milliseconds(2), 4);
+
+  // the cancelled entries share the slot with the remaining one
+  std::vector<int> fired;
+  auto first = wheel.schedule(std::chrono::milliseconds(4),
+                              [&]() { fired.push_back(1); });
+  auto second = wheel.schedule(std::chrono::milliseconds(4),
+                               [&]() { fired.push_back(2); });
+  auto third = wheel.schedule(std::chrono::milliseconds(4), [&]() {
+    fired.push_back(3);
+    wheel.stop();
+  });
+  auto released = std::make_shared<int>(0);
+  auto fourth = wheel.schedule(std::chrono::milliseconds(20),
+                               [released]() {});
+  EXPECT_EQ(wheel.size(), 4u);
+
+  EXPECT_TRUE(wheel.cancel(first));
+  EXPECT_TRUE(wheel.cancel(fourth));
+  EXPECT_FALSE(wheel.cancel(fourth));
+  EXPECT_EQ(released.use_count(), 1); // the callback is gone right away
+  EXPECT_TRUE(wheel.cancel(second));
+  EXPECT_EQ(wheel.size(), 1u);
+
+  wheel.start();
+  ioserv.run();
+
+  EXPECT_EQ(fired, (std::vector<int>{3}));
+  EXPECT_FALSE(wheel.cancel(third)); // already fired
+  EXPECT_EQ(wheel.size(), 0u);
+  EXPECT_FALSE(wheel.running());
+}
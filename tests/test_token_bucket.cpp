@@ -0,0 +1,30 @@
+#include "net_token_bucket.hpp"
+#include <gtest/gtest.h>
+
+TEST(token_bucket_test_case, refill_and_debt_test) {
+
+  custom_netlib::TokenBucket unlimited;
+  unlimited.consume(1e9);
+  EXPECT_FALSE(unlimited.empty());
+
+  // 100 tokens per second, 10 tokens capacity (the bucket starts full)
+  custom_netlib::TokenBucket bucket(100, 10);
+  auto start = custom_netlib::TokenBucket::clock_type::now();
+  bucket.refill(start);
+  bucket.consume(10);
+  EXPECT_TRUE(bucket.empty());
+  EXPECT_GT(bucket.timeUntilAvailable().count(), 0);
+
+  // an event that costs more than the capacity is possible, but the bucket
+  // needs longer to recover from the debt
+  bucket.refill(start + std::chrono::milliseconds(100)); // +10 tokens
+  EXPECT_FALSE(bucket.empty());
+  bucket.consume(30);
+  EXPECT_TRUE(bucket.empty());
+  EXPECT_GE(bucket.timeUntilAvailable(), std::chrono::milliseconds(200));
+
+  // the bucket never holds more than its capacity
+  bucket.refill(start + std::chrono::seconds(10));
+  bucket.consume(10);
+  EXPECT_TRUE(bucket.empty());
+}
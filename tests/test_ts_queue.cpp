@@ -0,0 +1,18 @@
+#include "net_ts_queue.hpp"
+#include <gtest/gtest.h>
+
+TEST(ts_queue_test_case, wait_for_timeout_test) {
+
+  custom_netlib::TsNetQueue<int> queue;
+  queue.setSpinDuration(std::chrono::seconds(2));
+
+  // the spinning does not outlast a shorter timeout
+  auto t_start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(queue.waitFor(std::chrono::milliseconds(10)));
+  EXPECT_LT(std::chrono::steady_clock::now() - t_start,
+            std::chrono::seconds(1));
+
+  queue.pushBack(42);
+  EXPECT_TRUE(queue.waitFor(std::chrono::milliseconds(10)));
+  EXPECT_EQ(queue.popFront(), 42);
+}
@@ -0,0 +1,46 @@
+#include "net_worker_pool.hpp"
+#include <gtest/gtest.h>
+
+TEST(worker_pool_test_case, per_key_order_test) {
+
+  // task = (key, sequence number of the task within its key)
+  using Task = std::pair<size_t, size_t>;
+  const size_t num_keys = 8;
+  const size_t tasks_per_key = 1000;
+
+  std::vector<std::vector<size_t>> processed(num_keys);
+  std::atomic<size_t> num_processed{0};
+  custom_netlib::WorkerPool<Task> pool(3, [&](Task &task) {
+    // every key is handled by exactly one worker, so no lock is needed here
+    processed[task.first].push_back(task.second);
+    num_processed++;
+  });
+
+  // tasks that are pushed before the start wait within the queues
+  pool.push(0, Task(0, 0));
+  EXPECT_EQ(pool.queueDepth(0), 1u);
+
+  pool.start();
+  for (size_t key = 1; key < num_keys; key++) {
+    pool.push(key, Task(key, 0));
+  }
+  for (size_t seq = 1; seq < tasks_per_key; seq++) {
+    for (size_t key = 0; key < num_keys; key++) {
+      pool.push(key, Task(key, seq));
+    }
+  }
+
+  while (num_processed < num_keys * tasks_per_key) {
+    std::this_thread::yield();
+  }
+  pool.stop();
+
+  for (size_t key = 0; key < num_keys; key++) {
+    ASSERT_EQ(processed[key].size(), tasks_per_key);
+    for (size_t n = 0; n < tasks_per_key; n++) {
+      // the tasks of one key are processed in the order of their arrival
+      EXPECT_EQ(processed[key][n], n);
+    }
+  }
+  EXPECT_EQ(pool.queueDepths(), std::vector<size_t>(3, 0));
+}